@@ -152,6 +152,30 @@
 #   in CMake, so this change is compatible).
 ##end
 #
+##variable
+#   CPACK_ARCHIVE_JOBS - Number of processes compressing the package at
+#   once with the TGZ, TBZ2 and STGZ generators. With more than one the
+#   archive is compressed in blocks that gunzip and bunzip2 decode as a
+#   single stream. Defaults to 1.
+##end
+#
+##variable
+#   CPACK_INSTALL_JOBS - Number of components of a component install
+#   that are installed at once, each by a cmake process of its own.
+#   Components sharing a staging directory are always installed one
+#   after the other. Defaults to 1.
+##end
+#
+##variable
+#   CPACK_INCREMENTAL_STAGING - If set, keep the staging tree under
+#   _CPack_Packages between runs and bring it up to date: files whose
+#   time and content did not change are not copied again, files no
+#   longer installed are removed, and the TGZ, TBZ2, TZ and ZIP
+#   generators only re-create the packages of components that changed.
+#   Only used when the project is installed through
+#   CPACK_INSTALL_CMAKE_PROJECTS alone.
+##end
+#
 # The following CPack variables are specific to source packages, and 
 # will not affect binary packages:
 #
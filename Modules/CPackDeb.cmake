@@ -171,11 +171,6 @@ IF(NOT DEFINED CPACK_DEBIAN_PACKAGE_SHLIBDEPS)
   SET(CPACK_DEBIAN_PACKAGE_SHLIBDEPS OFF)
 ENDIF(NOT DEFINED CPACK_DEBIAN_PACKAGE_SHLIBDEPS)
 
-FIND_PROGRAM(FAKEROOT_EXECUTABLE fakeroot)
-IF(FAKEROOT_EXECUTABLE)
-  SET(CPACK_DEBIAN_FAKEROOT_EXECUTABLE ${FAKEROOT_EXECUTABLE})
-ENDIF(FAKEROOT_EXECUTABLE)
-
 IF(CPACK_DEBIAN_PACKAGE_SHLIBDEPS)
   # dpkg-shlibdeps is a Debian utility for generating dependency list
   FIND_PROGRAM(SHLIBDEPS_EXECUTABLE dpkg-shlibdeps)
@@ -19,7 +19,9 @@
 #include "cmMakefile.h"
 #include "cmGeneratedFileStream.h"
 #include "cmCPackLog.h"
+#include "cmCryptoHash.h"
 #include <errno.h>
+#include <sys/stat.h>
 
 #include <cmsys/SystemTools.hxx>
 #include <cmsys/Directory.hxx>
@@ -44,6 +46,14 @@ int cmCPackArchiveGenerator::InitializeInternal()
   this->SetOptionIfNotSet("CPACK_INCLUDE_TOPLEVEL_DIRECTORY", "1");
   return this->Superclass::InitializeInternal();
 }
+//----------------------------------------------------------------------
+unsigned int cmCPackArchiveGenerator::GetCompressionJobs()
+{
+  const char* jobs = this->GetOption("CPACK_ARCHIVE_JOBS");
+  int value = jobs? atoi(jobs) : 1;
+  return value > 1? static_cast<unsigned int>(value) : 1;
+}
+
 //----------------------------------------------------------------------
 int cmCPackArchiveGenerator::addOneComponentToArchive(cmArchiveWrite& archive,
                              cmCPackComponent* component)
@@ -100,7 +110,9 @@ if (!GenerateHeader(&gf)) \
             << ">." << std::endl); \
     return 0; \
   } \
-cmArchiveWrite archive(gf,this->Compress, this->Archive); \
+cmArchiveWrite archive(gf,this->Compress, this->Archive, \
+  this->GetCompressionJobs(), \
+  this->GetOption("CPACK_TOPLEVEL_DIRECTORY")); \
 if (!archive) \
   { \
   cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem to create archive < " \
@@ -111,6 +123,155 @@ if (!archive) \
   return 0; \
   }
 
+/*
+ * The macro will write the end of the cmArchiveWrite 'archive'
+ * object declared by DECLARE_AND_OPEN_ARCHIVE and fail on error.
+ */
+#define FINISH_ARCHIVE(filename,archive) \
+if (!archive.Finish()) \
+  { \
+  cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem to finish archive < " \
+     << filename \
+     << ">. ERROR =" \
+     << archive.GetError() \
+     << std::endl); \
+  return 0; \
+  }
+
+//----------------------------------------------------------------------
+std::string cmCPackArchiveGenerator::GetPackageStamp(
+  std::vector<cmCPackComponent*> const& components,
+  FileHashMap const& oldHashes, long oldHashTime, FileHashMap& hashes)
+{
+  cmCryptoHashMD5 md5;
+  cmOStringStream stamp;
+  if (this->IsOn("CPACK_COMPONENT_INCLUDE_TOPLEVEL_DIRECTORY"))
+    {
+    stamp << this->GetOption("CPACK_PACKAGE_FILE_NAME") << "\n";
+    }
+  std::vector<cmCPackComponent*>::const_iterator compIt;
+  for (compIt = components.begin(); compIt != components.end(); ++compIt)
+    {
+    std::string localToplevel(this->GetOption("CPACK_TEMPORARY_DIRECTORY"));
+    localToplevel += "/"+ (*compIt)->Name;
+    stamp << (*compIt)->Name << "\n";
+    std::vector<std::string>::const_iterator fileIt;
+    for (fileIt = (*compIt)->Files.begin();
+         fileIt != (*compIt)->Files.end(); ++fileIt)
+      {
+      std::string file = localToplevel + "/" + *fileIt;
+      std::string key = (*compIt)->Name + "/" + *fileIt;
+      mode_t perm = 0;
+      cmSystemTools::GetPermissions(file.c_str(), perm);
+      stamp << *fileIt << " " << perm;
+      std::string target;
+      if (cmSystemTools::FileIsSymlink(file.c_str()) &&
+          cmSystemTools::ReadSymlink(file.c_str(), target))
+        {
+        stamp << " -> " << target;
+        }
+
+      // Stripping and other edits after installation give a file a new
+      // time on every run, so the content is what counts.  The hash of
+      // an earlier run is reused for the same file with the same time
+      // and size, unless it changed in the second the hash was taken.
+      FileHash h;
+      struct stat st;
+      if (stat(file.c_str(), &st) == 0)
+        {
+        h.Inode = static_cast<unsigned long>(st.st_ino);
+        h.MTime = static_cast<long>(st.st_mtime);
+        h.Size = static_cast<unsigned long>(st.st_size);
+        FileHashMap::const_iterator old = oldHashes.find(key);
+        if (old != oldHashes.end() && old->second.Inode == h.Inode &&
+            old->second.MTime == h.MTime && old->second.Size == h.Size &&
+            h.MTime < oldHashTime)
+          {
+          h.Hash = old->second.Hash;
+          }
+        else
+          {
+          h.Hash = md5.HashFile(file.c_str());
+          }
+        hashes[key] = h;
+        stamp << " " << h.Size << " " << h.Hash;
+        }
+      stamp << "\n";
+      }
+    }
+  return md5.HashString(stamp.str().c_str());
+}
+
+//----------------------------------------------------------------------
+int cmCPackArchiveGenerator::PackageComponentsToFile(
+  std::string const& packageFileName,
+  std::vector<cmCPackComponent*> const& components)
+{
+  // With incremental staging keep a package whose components have
+  // not changed since it was written.  The stamp file holds the stamp
+  // of the package, the time its file hashes were taken and then one
+  // line "<inode> <time> <size> <md5> <name>" for each file.
+  std::string stampFile = packageFileName + ".stamp";
+  std::string oldStamp;
+  long oldHashTime = 0;
+  FileHashMap oldHashes;
+  if (this->UseIncrementalStaging())
+    {
+    std::ifstream fin(stampFile.c_str());
+    std::string line;
+    if (cmSystemTools::GetLineFromStream(fin, oldStamp) &&
+        cmSystemTools::GetLineFromStream(fin, line))
+      {
+      oldHashTime = atol(line.c_str());
+      while (cmSystemTools::GetLineFromStream(fin, line))
+        {
+        FileHash h;
+        char hash[33];
+        int pos = 0;
+        if (sscanf(line.c_str(), "%lu %ld %lu %32s %n", &h.Inode, &h.MTime,
+                   &h.Size, hash, &pos) == 4 && pos > 0)
+          {
+          h.Hash = hash;
+          oldHashes[line.substr(pos)] = h;
+          }
+        }
+      }
+    }
+  long hashTime = static_cast<long>(time(0));
+  FileHashMap hashes;
+  std::string stamp =
+    this->GetPackageStamp(components, oldHashes, oldHashTime, hashes);
+  if (this->UseIncrementalStaging() && oldStamp == stamp &&
+      cmSystemTools::FileExists(packageFileName.c_str()))
+    {
+    cmCPackLogger(cmCPackLog::LOG_VERBOSE, "   - reuse package: "
+                  << packageFileName << std::endl);
+    }
+  else
+    {
+    // The archive is closed at the end of this block.
+    cmSystemTools::RemoveFile(stampFile.c_str());
+    DECLARE_AND_OPEN_ARCHIVE(packageFileName,archive);
+    // now iterate over the components
+    std::vector<cmCPackComponent*>::const_iterator compIt;
+    for (compIt = components.begin(); compIt != components.end(); ++compIt)
+      {
+      // Add the files of this component to the archive
+      addOneComponentToArchive(archive,*compIt);
+      }
+    FINISH_ARCHIVE(packageFileName,archive);
+    }
+  cmGeneratedFileStream fout(stampFile.c_str());
+  fout << stamp << "\n" << hashTime << "\n";
+  for (FileHashMap::const_iterator h = hashes.begin(); h != hashes.end(); ++h)
+    {
+    fout << h->second.Inode << " " << h->second.MTime << " "
+         << h->second.Size << " " << h->second.Hash << " " << h->first
+         << "\n";
+    }
+  return 1;
+}
+
 //----------------------------------------------------------------------
 int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
 {
@@ -133,20 +294,11 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
                                    compGIt->first,
                                    true)
          + this->GetOutputExtension();
-      // open a block in order to automatically close archive
-      // at the end of the block
-      {
-        DECLARE_AND_OPEN_ARCHIVE(packageFileName,archive);
-        // now iterate over the component of this group
-        std::vector<cmCPackComponent*>::iterator compIt;
-        for (compIt=(compGIt->second).Components.begin();
-            compIt!=(compGIt->second).Components.end();
-            ++compIt)
-          {
-          // Add the files of this component to the archive
-          addOneComponentToArchive(archive,*compIt);
-          }
-      }
+      if (!this->PackageComponentsToFile(packageFileName,
+                                         compGIt->second.Components))
+        {
+        return 0;
+        }
       // add the generated package to package file names list
       packageFileNames.push_back(packageFileName);
       }
@@ -174,11 +326,11 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
                                     compIt->first,
                                     false)
                               + this->GetOutputExtension();
-        {
-          DECLARE_AND_OPEN_ARCHIVE(packageFileName,archive);
-          // Add the files of this component to the archive
-          addOneComponentToArchive(archive,&(compIt->second));
-        }
+        std::vector<cmCPackComponent*> components(1, &compIt->second);
+        if (!this->PackageComponentsToFile(packageFileName, components))
+          {
+          return 0;
+          }
         // add the generated package to package file names list
         packageFileNames.push_back(packageFileName);
         }
@@ -201,11 +353,11 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
                                    compIt->first,
                                    false)
         + this->GetOutputExtension();
-      {
-        DECLARE_AND_OPEN_ARCHIVE(packageFileName,archive);
-        // Add the files of this component to the archive
-        addOneComponentToArchive(archive,&(compIt->second));
-      }
+      std::vector<cmCPackComponent*> components(1, &compIt->second);
+      if (!this->PackageComponentsToFile(packageFileName, components))
+        {
+        return 0;
+        }
       // add the generated package to package file names list
       packageFileNames.push_back(packageFileName);
       }
@@ -236,8 +388,7 @@ int cmCPackArchiveGenerator::PackageComponentsAllInOne()
     // Add the files of this component to the archive
     addOneComponentToArchive(archive,&(compIt->second));
     }
-
-  // archive goes out of scope so it will finalized and closed.
+  FINISH_ARCHIVE(packageFileNames[0],archive);
   return 1;
 }
 
@@ -289,7 +440,7 @@ int cmCPackArchiveGenerator::PackageFiles()
       }
     }
   cmSystemTools::ChangeDirectory(dir.c_str());
-  // The destructor of cmArchiveWrite will close and finish the write
+  FINISH_ARCHIVE(packageFileNames[0],archive);
   return 1;
 }
 
@@ -61,11 +61,42 @@ protected:
    * archive for each component group.
    */
   int PackageComponents(bool ignoreGroup);
+  /**
+   * Write the archive of the given components to packageFileName.  With
+   * incremental staging an archive whose components did not change
+   * since it was written, as recorded by a stamp next to it, is kept.
+   */
+  int PackageComponentsToFile(std::string const& packageFileName,
+                              std::vector<cmCPackComponent*> const&
+                              components);
+  /** The content hash of a staged file and what it was taken for.  */
+  struct FileHash
+  {
+    unsigned long Inode;
+    long MTime;
+    unsigned long Size;
+    std::string Hash;
+  };
+  typedef std::map<std::string, FileHash> FileHashMap;
+  /**
+   * A hash of the names, permissions, sizes and content hashes of the
+   * files of the given components.  The content hashes are returned in
+   * "hashes"; those of "oldHashes", taken at "oldHashTime", are reused
+   * for files that did not change since.
+   */
+  std::string GetPackageStamp(
+    std::vector<cmCPackComponent*> const& components,
+    FileHashMap const& oldHashes, long oldHashTime, FileHashMap& hashes);
   /**
    * Special case of component install where all
    * components will be put in a single installer.
    */
   int PackageComponentsAllInOne();
+  /**
+   * The number of processes compressing the archive at once, as given
+   * by CPACK_ARCHIVE_JOBS.
+   */
+  unsigned int GetCompressionJobs();
   virtual const char* GetOutputExtension() = 0;
   cmArchiveWrite::Compress Compress;
   cmArchiveWrite::Type Archive;
@@ -14,6 +14,7 @@
 #include "cmSystemTools.h"
 #include "cmMakefile.h"
 #include "cmGeneratedFileStream.h"
+#include "cmArchiveWrite.h"
 #include "cmCPackLog.h"
 
 #include <cmsys/SystemTools.hxx>
@@ -274,8 +275,6 @@ int cmCPackDebGenerator::PackageFiles()
 
 int cmCPackDebGenerator::createDeb()
 {
-  const char* cmakeExecutable = this->GetOption("CMAKE_COMMAND");
-
   // debian-binary file
   std::string dbfilename;
     dbfilename += this->GetOption("WDIR");
@@ -391,59 +390,59 @@ int cmCPackDebGenerator::createDeb()
     out << std::endl;
     }
 
-  std::string cmd;
-  if (NULL != this->GetOption("CPACK_DEBIAN_FAKEROOT_EXECUTABLE")) {
-      cmd += this->GetOption("CPACK_DEBIAN_FAKEROOT_EXECUTABLE");
-  }
-  cmd += " \"";
-  cmd += cmakeExecutable;
-  cmd += "\" -E tar cfz data.tar.gz ";
-
   // now add all directories which have to be compressed
   // collect all top level install dirs for that
   // e.g. /opt/bin/foo, /usr/bin/bar and /usr/bin/baz would give /usr and /opt
-    size_t topLevelLength = std::string(this->GetOption("WDIR")).length();
-    cmCPackLogger(cmCPackLog::LOG_DEBUG, "WDIR: \"" << this->GetOption("WDIR")
-          << "\", length = " << topLevelLength
-          << std::endl);
+  std::string topLevelString = this->GetOption("WDIR");
+  size_t topLevelLength = topLevelString.length();
+  cmCPackLogger(cmCPackLog::LOG_DEBUG, "WDIR: \"" << topLevelString
+        << "\", length = " << topLevelLength
+        << std::endl);
   std::set<std::string> installDirs;
-    for (std::vector<std::string>::const_iterator fileIt =
-        packageFiles.begin();
-        fileIt != packageFiles.end(); ++ fileIt )
+  std::vector<std::string> installDirList;
+  for (std::vector<std::string>::const_iterator fileIt =
+      packageFiles.begin();
+      fileIt != packageFiles.end(); ++ fileIt )
     {
-      cmCPackLogger(cmCPackLog::LOG_DEBUG, "FILEIT: \"" << *fileIt << "\""
-          << std::endl);
+    cmCPackLogger(cmCPackLog::LOG_DEBUG, "FILEIT: \"" << *fileIt << "\""
+        << std::endl);
     std::string::size_type slashPos = fileIt->find('/', topLevelLength+1);
     std::string relativeDir = fileIt->substr(topLevelLength,
                                              slashPos - topLevelLength);
-      cmCPackLogger(cmCPackLog::LOG_DEBUG, "RELATIVEDIR: \"" << relativeDir
-      << "\"" << std::endl);
-    if (installDirs.find(relativeDir) == installDirs.end())
+    cmCPackLogger(cmCPackLog::LOG_DEBUG, "RELATIVEDIR: \"" << relativeDir
+        << "\"" << std::endl);
+    if (installDirs.insert(relativeDir).second)
       {
-      installDirs.insert(relativeDir);
-      cmd += " .";
-      cmd += relativeDir;
+      installDirList.push_back(relativeDir);
       }
     }
 
-  std::string output;
-    int retval = -1;
-  int res = cmSystemTools::RunSingleCommand(cmd.c_str(), &output,
-      &retval, this->GetOption("WDIR"), this->GeneratorVerbose, 0);
-
-    if ( !res || retval )
+  // Write data.tar.gz in-process.  Debian packages are owned by root,
+  // and the md5sum of every file is computed while it is compressed so
+  // that each file is read only once.
+  std::map<cmStdString, std::string> md5sums;
+  std::string dataFileName = topLevelString + "/data.tar.gz";
     {
-    std::string tmpFile = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
-    tmpFile += "/Deb.log";
-    cmGeneratedFileStream ofs(tmpFile.c_str());
-    ofs << "# Run command: " << cmd.c_str() << std::endl
-      << "# Working directory: " << toplevel << std::endl
-      << "# Output:" << std::endl
-      << output.c_str() << std::endl;
-    cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem running tar command: "
-      << cmd.c_str() << std::endl
-      << "Please check " << tmpFile.c_str() << " for errors" << std::endl);
-    return 0;
+    cmGeneratedFileStream fileStream_data_tar;
+    fileStream_data_tar.Open(dataFileName.c_str(), false, true);
+    cmArchiveWrite data_tar(fileStream_data_tar, cmArchiveWrite::CompressGZip,
+                            cmArchiveWrite::TypeTAR);
+    data_tar.SetOwner(0, 0, "root", "root");
+    data_tar.SetFileHash("MD5");
+    data_tar.SetVerbose(this->GeneratorVerbose);
+    for (std::vector<std::string>::const_iterator dirIt =
+          installDirList.begin();
+         data_tar && dirIt != installDirList.end(); ++dirIt)
+      {
+      data_tar.Add(topLevelString + *dirIt, topLevelLength, ".");
+      }
+    if (!data_tar || !data_tar.Finish())
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem creating archive "
+        << dataFileName << ": " << data_tar.GetError() << std::endl);
+      return 0;
+      }
+    md5sums = data_tar.GetFileHashes();
     }
 
   std::string md5filename;
@@ -453,25 +452,23 @@ int cmCPackDebGenerator::createDeb()
     { // the scope is needed for cmGeneratedFileStream
     cmGeneratedFileStream out(md5filename.c_str());
     std::vector<std::string>::const_iterator fileIt;
-//       std::string topLevelWithTrailingSlash = toplevel;
     std::string topLevelWithTrailingSlash =
         this->GetOption("CPACK_TEMPORARY_DIRECTORY");
     topLevelWithTrailingSlash += '/';
+    cmCryptoHashMD5 md5;
       for ( fileIt = packageFiles.begin();
             fileIt != packageFiles.end(); ++ fileIt )
       {
-      cmd = "\"";
-      cmd += cmakeExecutable;
-      cmd += "\" -E md5sum \"";
-      cmd += *fileIt;
-      cmd += "\"";
-      //std::string output;
-      //int retVal = -1;
-      res = cmSystemTools::RunSingleCommand(cmd.c_str(), &output,
-          &retval, toplevel.c_str(), this->GeneratorVerbose, 0);
+      // Files not hashed while writing the archive, such as symlinks,
+      // are hashed on their own.
+      std::map<cmStdString, std::string>::const_iterator h =
+        md5sums.find(*fileIt);
+      std::string hash = h != md5sums.end() ?
+        h->second : md5.HashFile(fileIt->c_str());
       // debian md5sums entries are like this:
       // 014f3604694729f3bf19263bac599765  usr/bin/ccmake
       // thus strip the full path (with the trailing slash)
+      std::string output = hash + "  " + *fileIt + "\n";
       cmSystemTools::ReplaceString(output,
                                    topLevelWithTrailingSlash.c_str(), "");
       out << output;
@@ -480,9 +477,9 @@ int cmCPackDebGenerator::createDeb()
     // Do not end the md5sum file with yet another (invalid)
     }
 
-  cmd = "\"";
-  cmd += cmakeExecutable;
-  cmd += "\" -E tar cfz control.tar.gz ./control ./md5sums";
+  std::vector<std::string> controlFiles;
+  controlFiles.push_back("control");
+  controlFiles.push_back("md5sums");
   const char* controlExtra =
     this->GetOption("CPACK_DEBIAN_PACKAGE_CONTROL_EXTRA");
   if( controlExtra )
@@ -501,43 +498,45 @@ int cmCPackDebGenerator::createDeb()
       if( cmsys::SystemTools::CopyFileIfDifferent(
             i->c_str(), localcopy.c_str()) )
         {
-        // debian is picky and need relative to ./ path in the tar.gz
-        cmd += " ./";
-        cmd += filenamename;
+        controlFiles.push_back(filenamename);
         }
       }
     }
-  res = cmSystemTools::RunSingleCommand(cmd.c_str(), &output,
-      &retval, this->GetOption("WDIR"), this->GeneratorVerbose, 0);
 
-    if ( !res || retval )
+  std::string controlFileName = topLevelString + "/control.tar.gz";
     {
-    std::string tmpFile = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
-    tmpFile += "/Deb.log";
-    cmGeneratedFileStream ofs(tmpFile.c_str());
-    ofs << "# Run command: " << cmd.c_str() << std::endl
-      << "# Working directory: " << toplevel << std::endl
-      << "# Output:" << std::endl
-      << output.c_str() << std::endl;
-    cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem running tar command: "
-      << cmd.c_str() << std::endl
-      << "Please check " << tmpFile.c_str() << " for errors" << std::endl);
-    return 0;
+    cmGeneratedFileStream fileStream_control_tar;
+    fileStream_control_tar.Open(controlFileName.c_str(), false, true);
+    cmArchiveWrite control_tar(fileStream_control_tar,
+                               cmArchiveWrite::CompressGZip,
+                               cmArchiveWrite::TypeTAR);
+    control_tar.SetOwner(0, 0, "root", "root");
+    control_tar.SetVerbose(this->GeneratorVerbose);
+    // debian is picky and need relative to ./ path in the tar.gz
+    for (std::vector<std::string>::const_iterator i = controlFiles.begin();
+         control_tar && i != controlFiles.end(); ++i)
+      {
+      control_tar.Add(topLevelString + "/" + *i, topLevelLength, ".");
+      }
+    if (!control_tar || !control_tar.Finish())
+      {
+      cmCPackLogger(cmCPackLog::LOG_ERROR, "Problem creating archive "
+        << controlFileName << ": " << control_tar.GetError() << std::endl);
+      return 0;
+      }
     }
 
   // ar -r your-package-name.deb debian-binary control.tar.gz data.tar.gz
   // since debian packages require BSD ar (most Linux distros and even
   // FreeBSD and NetBSD ship GNU ar) we use a copy of OpenBSD ar here.
   std::vector<std::string> arFiles;
-    std::string topLevelString = this->GetOption("WDIR");
-  topLevelString += "/";
-  arFiles.push_back(topLevelString + "debian-binary");
-  arFiles.push_back(topLevelString + "control.tar.gz");
-  arFiles.push_back(topLevelString + "data.tar.gz");
+  arFiles.push_back(topLevelString + "/debian-binary");
+  arFiles.push_back(controlFileName);
+  arFiles.push_back(dataFileName);
     std::string outputFileName = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
     outputFileName += "/";
     outputFileName += this->GetOption("CPACK_OUTPUT_FILE_NAME");
-    res = ar_append(outputFileName.c_str(), arFiles);
+  int res = ar_append(outputFileName.c_str(), arFiles);
   if ( res!=0 )
     {
     std::string tmpFile = this->GetOption("CPACK_TEMPORARY_PACKAGE_FILE_NAME");
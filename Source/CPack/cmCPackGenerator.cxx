@@ -23,8 +23,11 @@
 
 #include <cmsys/SystemTools.hxx>
 #include <cmsys/Glob.hxx>
+#include <cmsys/Process.h>
 #include <memory> // auto_ptr
 #include <algorithm>
+#include <deque>
+#include <set>
 
 #if defined(__HAIKU__)
 #include <StorageKit.h>
@@ -168,7 +171,23 @@ int cmCPackGenerator::PrepareNames()
 int cmCPackGenerator::InstallProject()
 {
   cmCPackLogger(cmCPackLog::LOG_OUTPUT, "Install projects" << std::endl);
-  this->CleanTemporaryDirectory();
+  bool incremental = this->UseIncrementalStaging();
+  if (incremental)
+    {
+    // Let file(INSTALL) skip files whose content did not change.
+    const char* staging =
+      this->GetOption("CPACK_TEMPORARY_INSTALL_DIRECTORY");
+    if (cmSystemTools::FileExists(staging))
+      {
+      cmCPackLogger(cmCPackLog::LOG_OUTPUT,
+                    "- Reuse temporary : " << staging << std::endl);
+      }
+    cmSystemTools::PutEnv("CMAKE_INSTALL_COMPARE_CONTENT=1");
+    }
+  else
+    {
+    this->CleanTemporaryDirectory();
+    }
 
   std::string bareTempInstallDirectory
     = this->GetOption("CPACK_TEMPORARY_INSTALL_DIRECTORY");
@@ -242,6 +261,10 @@ int cmCPackGenerator::InstallProject()
     {
     cmSystemTools::PutEnv("DESTDIR=");
     }
+  if ( incremental )
+    {
+    cmSystemTools::PutEnv("CMAKE_INSTALL_COMPARE_CONTENT=");
+    }
 
   return res;
 }
@@ -498,6 +521,220 @@ int cmCPackGenerator::InstallProjectViaInstallScript(
   return 1;
 }
 
+//----------------------------------------------------------------------
+// The install of one component of a CMake project.
+struct cmCPackComponentInstall
+{
+  typedef std::pair<cmStdString, cmStdString> Definition;
+  cmCPackComponentInstall():
+    ComponentInstall(false), HasAbsoluteDestinationFiles(false), Result(1) {}
+  std::string Component;
+  bool ComponentInstall;
+  std::string Directory;
+  std::string DestDir;
+  std::vector<Definition> Definitions;
+  std::vector<std::string> FilesBefore;
+  std::vector<std::string> FilesAdded;
+  std::string Manifest;
+  bool HasAbsoluteDestinationFiles;
+  std::string AbsoluteDestinationFiles;
+  std::string Output;
+  std::string Error;
+  int Result;
+};
+
+//----------------------------------------------------------------------
+static std::vector<std::string>
+cmCPackGlobInstalledFiles(std::string const& dir)
+{
+  cmsys::Glob gl;
+  gl.RecurseOn();
+  gl.FindFiles(dir + "/*");
+  std::vector<std::string> files = gl.GetFiles();
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+//----------------------------------------------------------------------
+// The files on disk listed by the install manifest of a component that
+// still exist in the staging tree.
+static std::vector<std::string>
+cmCPackGetManifestFiles(cmCPackComponentInstall const& ci)
+{
+  std::vector<std::string> entries;
+  cmSystemTools::ExpandListArgument(ci.Manifest, entries);
+  std::vector<std::string> files;
+  for(std::vector<std::string>::const_iterator i = entries.begin();
+      i != entries.end(); ++i)
+    {
+    std::string file = ci.DestDir + *i;
+    if(cmSystemTools::FileExists(file.c_str()) ||
+       cmSystemTools::FileIsSymlink(file.c_str()))
+      {
+      files.push_back(file);
+      }
+    }
+  return files;
+}
+
+//----------------------------------------------------------------------
+static std::string cmCPackQuoteScriptString(std::string const& value)
+{
+  std::string quoted = "\"";
+  for(std::string::const_iterator c = value.begin(); c != value.end(); ++c)
+    {
+    if(*c == '\\' || *c == '"' || *c == '$')
+      {
+      quoted += '\\';
+      }
+    quoted += *c;
+    }
+  quoted += "\"";
+  return quoted;
+}
+
+//----------------------------------------------------------------------
+static std::string cmCPackReadInstallLog(std::string const& fname)
+{
+  std::string content;
+  std::ifstream fin(fname.c_str());
+  std::string line;
+  bool haveNewline;
+  while(cmSystemTools::GetLineFromStream(fin, line, &haveNewline))
+    {
+    content += line;
+    if(haveNewline)
+      {
+      content += "\n";
+      }
+    }
+  fin.close();
+  cmSystemTools::RemoveFile(fname.c_str());
+  return content;
+}
+
+//----------------------------------------------------------------------
+static void cmCPackFinishComponentInstall(cmsysProcess* cp,
+                                          cmCPackComponentInstall& ci,
+                                          std::string const& base)
+{
+  cmsysProcess_WaitForExit(cp, 0);
+  int state = cmsysProcess_GetState(cp);
+  ci.Output = cmCPackReadInstallLog(base + ".out");
+  std::string errors = cmCPackReadInstallLog(base + ".err");
+  if(state == cmsysProcess_State_Exited && cmsysProcess_GetExitValue(cp) == 0)
+    {
+    ci.Output += errors;
+    ci.Result = 1;
+    std::string manifestFile = base + ".manifest";
+    if(cmSystemTools::FileExists(manifestFile.c_str()))
+      {
+      ci.Manifest = cmCPackReadInstallLog(manifestFile);
+      }
+    std::string absFile = base + ".abs";
+    if(cmSystemTools::FileExists(absFile.c_str()))
+      {
+      ci.AbsoluteDestinationFiles = cmCPackReadInstallLog(absFile);
+      ci.HasAbsoluteDestinationFiles = !ci.AbsoluteDestinationFiles.empty();
+      }
+    }
+  else
+    {
+    ci.Error = errors;
+    if(state == cmsysProcess_State_Error)
+      {
+      ci.Error += cmsysProcess_GetErrorString(cp);
+      }
+    else if(state == cmsysProcess_State_Exception)
+      {
+      ci.Error += cmsysProcess_GetExceptionString(cp);
+      }
+    std::string::size_type end = ci.Error.find_last_not_of(" \t\r\n");
+    ci.Error.erase(end == std::string::npos? 0 : end + 1);
+    ci.Result = 0;
+    }
+  cmsysProcess_Delete(cp);
+  cmSystemTools::RemoveFile((base + ".cmake").c_str());
+}
+
+//----------------------------------------------------------------------
+// Run the install script of each component in a cmake process of its
+// own, at most "jobs" at a time.  Each process gets a script setting
+// the variables the in-process install would define, and reports
+// CPACK_ABSOLUTE_DESTINATION_FILES and the install manifest back
+// through files.
+static void cmCPackRunComponentInstalls(
+  std::vector<cmCPackComponentInstall>& installs,
+  std::string const& installFile, std::string const& scriptDir,
+  unsigned int jobs)
+{
+  std::string cmake = cmSystemTools::GetExecutableDirectory();
+  cmake += "/cmake";
+  cmake += cmSystemTools::GetExecutableExtension();
+
+  std::deque<std::pair<cmsysProcess*, size_t> > running;
+  for(size_t i = 0; i <= installs.size(); ++i)
+    {
+    // Wait for the oldest install when the pool is full or when every
+    // component has been started.
+    while(!running.empty() &&
+          (running.size() >= jobs || i == installs.size()))
+      {
+      size_t done = running.front().second;
+      cmOStringStream base;
+      base << scriptDir << "/CPackInstallComponent" << done;
+      cmCPackFinishComponentInstall(running.front().first,
+                                    installs[done], base.str());
+      running.pop_front();
+      }
+    if(i == installs.size())
+      {
+      break;
+      }
+
+    cmCPackComponentInstall& ci = installs[i];
+    cmOStringStream base;
+    base << scriptDir << "/CPackInstallComponent" << i;
+    std::string script = base.str() + ".cmake";
+    std::string absFile = base.str() + ".abs";
+    std::string manifestFile = base.str() + ".manifest";
+    cmSystemTools::RemoveFile(absFile.c_str());
+    cmSystemTools::RemoveFile(manifestFile.c_str());
+    {
+    cmGeneratedFileStream fout(script.c_str());
+    std::vector<cmCPackComponentInstall::Definition>::const_iterator di;
+    for(di = ci.Definitions.begin(); di != ci.Definitions.end(); ++di)
+      {
+      fout << "set(" << di->first << " "
+           << cmCPackQuoteScriptString(di->second) << ")\n";
+      }
+    fout << "include(" << cmCPackQuoteScriptString(installFile) << ")\n"
+         << "if(DEFINED CPACK_ABSOLUTE_DESTINATION_FILES)\n"
+         << "  file(WRITE " << cmCPackQuoteScriptString(absFile)
+         << " \"${CPACK_ABSOLUTE_DESTINATION_FILES}\")\n"
+         << "endif()\n"
+         << "file(WRITE " << cmCPackQuoteScriptString(manifestFile)
+         << " \"${CMAKE_INSTALL_MANIFEST_FILES}\")\n";
+    }
+
+    // The child inherits DESTDIR from the environment at launch.
+    if(!ci.DestDir.empty())
+      {
+      cmSystemTools::PutEnv(("DESTDIR=" + ci.DestDir).c_str());
+      }
+    std::string out = base.str() + ".out";
+    std::string err = base.str() + ".err";
+    const char* cmd[] = {cmake.c_str(), "-P", script.c_str(), 0};
+    cmsysProcess* cp = cmsysProcess_New();
+    cmsysProcess_SetCommand(cp, cmd);
+    cmsysProcess_SetOption(cp, cmsysProcess_Option_HideWindow, 1);
+    cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDOUT, out.c_str());
+    cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDERR, err.c_str());
+    cmsysProcess_Execute(cp);
+    running.push_back(std::make_pair(cp, i));
+    }
+}
+
 //----------------------------------------------------------------------
 int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
   bool setDestDir, const char* baseTempInstallDirectory)
@@ -507,6 +744,7 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
   const char* cmakeGenerator
     = this->GetOption("CPACK_CMAKE_GENERATOR");
   std::string absoluteDestFiles;
+  std::vector<cmCPackComponentInstall> staged;
   if ( cmakeProjects && *cmakeProjects )
     {
     if ( !cmakeGenerator )
@@ -653,33 +891,21 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
       cmCPackLogger(cmCPackLog::LOG_OUTPUT,
         "- Install project: " << installProjectName << std::endl);
 
-      // Run the installation for each component
+      // Prepare the staging directory of each component
+      std::vector<cmCPackComponentInstall> installs;
+      std::set<cmStdString> installDirectories;
+      bool disjointDirectories = true;
       std::vector<std::string>::iterator componentIt;
       for (componentIt = componentsVector.begin();
            componentIt != componentsVector.end();
            ++componentIt)
         {
-        std::string tempInstallDirectory = baseTempInstallDirectory;
+        cmCPackComponentInstall ci;
+        ci.Component = *componentIt;
+        ci.ComponentInstall = componentInstall;
+        std::string& tempInstallDirectory = ci.Directory;
+        tempInstallDirectory = baseTempInstallDirectory;
         installComponent = *componentIt;
-        if (componentInstall)
-          {
-          cmCPackLogger(cmCPackLog::LOG_OUTPUT,
-                        "-   Install component: " << installComponent 
-                        << std::endl);
-          }
-        
-        cmake cm;
-        cm.AddCMakePaths();
-        cm.SetProgressCallback(cmCPackGeneratorProgress, this);
-        cmGlobalGenerator gg;
-        gg.SetCMakeInstance(&cm);
-        std::auto_ptr<cmLocalGenerator> lg(gg.CreateLocalGenerator());
-        cmMakefile *mf = lg->GetMakefile();
-        std::string realInstallDirectory = tempInstallDirectory;
-        if ( !installSubDirectory.empty() && installSubDirectory != "/" )
-          {
-          realInstallDirectory += installSubDirectory;
-          }
         if (componentInstall)
           {
           tempInstallDirectory += "/";
@@ -727,7 +953,8 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
             {
             dir += this->GetOption("CPACK_INSTALL_PREFIX");
             }
-          mf->AddDefinition("CMAKE_INSTALL_PREFIX", dir.c_str());
+          ci.Definitions.push_back(
+            cmCPackComponentInstall::Definition("CMAKE_INSTALL_PREFIX", dir));
 
           cmCPackLogger(
             cmCPackLog::LOG_DEBUG,
@@ -759,9 +986,7 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
            *     - Because it was already used for component install
            *       in order to put things in subdirs...
            */
-          cmSystemTools::PutEnv(
-              (std::string("DESTDIR=")+tempInstallDirectory).c_str()
-                               );
+          ci.DestDir = tempInstallDirectory;
           cmCPackLogger(cmCPackLog::LOG_DEBUG,
                         "- Creating directory: '" << dir << "'" << std::endl);
 
@@ -775,8 +1000,9 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
           }
         else
           {
-          mf->AddDefinition("CMAKE_INSTALL_PREFIX",
-                            tempInstallDirectory.c_str());
+          ci.Definitions.push_back(
+            cmCPackComponentInstall::Definition("CMAKE_INSTALL_PREFIX",
+                                                tempInstallDirectory));
 
           if ( !cmsys::SystemTools::MakeDirectory(
                  tempInstallDirectory.c_str()))
@@ -798,77 +1024,150 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
 
         if ( buildConfig && *buildConfig )
           {
-          mf->AddDefinition("BUILD_TYPE", buildConfig);
+          ci.Definitions.push_back(
+            cmCPackComponentInstall::Definition("BUILD_TYPE", buildConfig));
           }
         std::string installComponentLowerCase
           = cmSystemTools::LowerCase(installComponent);
         if ( installComponentLowerCase != "all" )
           {
-          mf->AddDefinition("CMAKE_INSTALL_COMPONENT",
-                            installComponent.c_str());
+          ci.Definitions.push_back(
+            cmCPackComponentInstall::Definition("CMAKE_INSTALL_COMPONENT",
+                                                installComponent));
           }
 
         // strip on TRUE, ON, 1, one or several file names, but not on 
         // FALSE, OFF, 0 and an empty string
         if (!cmSystemTools::IsOff(this->GetOption("CPACK_STRIP_FILES")))
           {
-          mf->AddDefinition("CMAKE_INSTALL_DO_STRIP", "1");
+          ci.Definitions.push_back(
+            cmCPackComponentInstall::Definition("CMAKE_INSTALL_DO_STRIP",
+                                                "1"));
           }
-        // Remember the list of files before installation
-        // of the current component (if we are in component install)
-        const char* InstallPrefix = tempInstallDirectory.c_str();
-        std::vector<std::string> filesBefore;
-        std::string findExpr(InstallPrefix);
+        if (!installDirectories.insert(tempInstallDirectory).second)
+          {
+          disjointDirectories = false;
+          }
+        installs.push_back(ci);
+        }
+
+      // Components that stage into directories of their own may be
+      // installed by several cmake processes at once.  The output of
+      // each one is logged in component order once it has finished.
+      const char* jobsOption = this->GetOption("CPACK_INSTALL_JOBS");
+      int jobsValue = jobsOption? atoi(jobsOption) : 1;
+      unsigned int jobs = jobsValue > 1?
+        static_cast<unsigned int>(jobsValue) : 1;
+      bool concurrent = componentInstall && disjointDirectories &&
+        jobs > 1 && installs.size() > 1;
+      if (concurrent)
+        {
+        cmCPackLogger(cmCPackLog::LOG_VERBOSE,
+                      "- Install " << installs.size() << " components with "
+                      << jobs << " processes" << std::endl);
+        std::vector<cmCPackComponentInstall>::iterator ciIt;
+        for (ciIt = installs.begin(); ciIt != installs.end(); ++ciIt)
+          {
+          ciIt->FilesBefore = cmCPackGlobInstalledFiles(ciIt->Directory);
+          }
+        std::string scriptDir = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+        cmCPackRunComponentInstalls(installs, installFile, scriptDir, jobs);
+        }
+
+      // Run the installation for each component
+      std::vector<cmCPackComponentInstall>::iterator ciIt;
+      for (ciIt = installs.begin(); ciIt != installs.end(); ++ciIt)
+        {
+        cmCPackComponentInstall& ci = *ciIt;
+        installComponent = ci.Component;
         if (componentInstall)
           {
-          cmsys::Glob glB;
-          findExpr += "/*";
-          glB.RecurseOn();
-          glB.FindFiles(findExpr);
-          filesBefore = glB.GetFiles();
-          std::sort(filesBefore.begin(),filesBefore.end());
+          cmCPackLogger(cmCPackLog::LOG_OUTPUT,
+                        "-   Install component: " << installComponent 
+                        << std::endl);
           }
-        // do installation
-        int res = mf->ReadListFile(0, installFile.c_str());
+
+        int res = 1;
+        if (concurrent)
+          {
+          // Log the output as the in-process install would report it.
+          std::vector<cmStdString> lines;
+          cmSystemTools::Split(ci.Output.c_str(), lines);
+          std::vector<cmStdString>::iterator li;
+          for (li = lines.begin(); li != lines.end(); ++li)
+            {
+            if (li->empty())
+              {
+              continue;
+              }
+            std::string::size_type start = li->find("-- ") == 0? 3 : 0;
+            cmCPackLogger(cmCPackLog::LOG_VERBOSE,
+                          li->substr(start) << std::endl);
+            }
+          res = ci.Result;
+          if (!res)
+            {
+            cmCPackLogger(cmCPackLog::LOG_ERROR,
+                          "Problem installing component: " << installComponent
+                          << std::endl << ci.Error << std::endl);
+            }
+          }
+        else
+          {
+          cmake cm;
+          cm.AddCMakePaths();
+          cm.SetProgressCallback(cmCPackGeneratorProgress, this);
+          cmGlobalGenerator gg;
+          gg.SetCMakeInstance(&cm);
+          std::auto_ptr<cmLocalGenerator> lg(gg.CreateLocalGenerator());
+          cmMakefile *mf = lg->GetMakefile();
+          std::vector<cmCPackComponentInstall::Definition>::iterator di;
+          for (di = ci.Definitions.begin(); di != ci.Definitions.end(); ++di)
+            {
+            mf->AddDefinition(di->first.c_str(), di->second.c_str());
+            }
+          if (!ci.DestDir.empty())
+            {
+            cmSystemTools::PutEnv(("DESTDIR=" + ci.DestDir).c_str());
+            }
+          // Remember the list of files before installation
+          // of the current component (if we are in component install)
+          if (componentInstall)
+            {
+            ci.FilesBefore = cmCPackGlobInstalledFiles(ci.Directory);
+            }
+          // do installation
+          res = mf->ReadListFile(0, installFile.c_str());
+          if (const char* absFiles =
+              mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES"))
+            {
+            ci.HasAbsoluteDestinationFiles = true;
+            ci.AbsoluteDestinationFiles = absFiles;
+            }
+          ci.Manifest = mf->GetSafeDefinition("CMAKE_INSTALL_MANIFEST_FILES");
+          }
+
         // Now rebuild the list of files after installation
         // of the current component (if we are in component install)
         if (componentInstall)
           {
-          cmsys::Glob glA;
-          glA.RecurseOn();
-          glA.FindFiles(findExpr);
-          std::vector<std::string> filesAfter = glA.GetFiles();
-          std::sort(filesAfter.begin(),filesAfter.end());
+          std::vector<std::string> filesAfter =
+            cmCPackGlobInstalledFiles(ci.Directory);
+          std::vector<std::string>& filesBefore = ci.FilesBefore;
           std::vector<std::string>::iterator diff;
           std::vector<std::string> result(filesAfter.size());
           diff = std::set_difference (
                   filesAfter.begin(),filesAfter.end(),
                   filesBefore.begin(),filesBefore.end(),
                   result.begin());
-
-          std::vector<std::string>::iterator fit;
-          std::string localFileName;
-          // Populate the File field of each component
-          for (fit=result.begin();fit!=diff;++fit)
-            {
-            localFileName =
-                cmSystemTools::RelativePath(InstallPrefix, fit->c_str());
-            localFileName =
-                localFileName.substr(localFileName.find('/')+1,
-                                     std::string::npos);
-            Components[installComponent].Files.push_back(localFileName);
-            cmCPackLogger(cmCPackLog::LOG_DEBUG, "Adding file <"
-                                <<localFileName<<"> to component <"
-                                <<installComponent<<">"<<std::endl);
-            }
+          ci.FilesAdded.assign(result.begin(), diff);
           }
 
-        if (NULL !=mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES")) {
+        if (ci.HasAbsoluteDestinationFiles) {
           if (absoluteDestFiles.length()>0) {
             absoluteDestFiles +=";";
           }
-          absoluteDestFiles +=
-            mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES");
+          absoluteDestFiles += ci.AbsoluteDestinationFiles;
           cmCPackLogger(cmCPackLog::LOG_DEBUG,
                                     "Got some ABSOLUTE DESTINATION FILES: "
                                     << absoluteDestFiles << std::endl);
@@ -884,14 +1183,14 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
                     this->GetOption(absoluteDestFileComponent.c_str());
                 absoluteDestFilesListComponent +=";";
                 absoluteDestFilesListComponent +=
-                    mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES");
+                    ci.AbsoluteDestinationFiles;
                 this->SetOption(absoluteDestFileComponent.c_str(),
                     absoluteDestFilesListComponent.c_str());
               }
             else
               {
               this->SetOption(absoluteDestFileComponent.c_str(),
-                  mf->GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES"));
+                  ci.AbsoluteDestinationFiles.c_str());
               }
             }
         }
@@ -899,14 +1198,123 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
           {
           return 0;
           }
+        staged.push_back(ci);
         }
       }
     }
+
+  // Remove the files a previous run staged that are no longer installed.
+  std::set<cmStdString> installed;
+  std::vector<cmCPackComponentInstall>::iterator sIt;
+  for (sIt = staged.begin(); sIt != staged.end(); ++sIt)
+    {
+    std::vector<std::string> manifest = cmCPackGetManifestFiles(*sIt);
+    installed.insert(manifest.begin(), manifest.end());
+    }
+  if (!this->UpdateStagingManifest(installed))
+    {
+    return 0;
+    }
+
+  // Populate the File field of each component
+  std::map<cmStdString, int> directoryUses;
+  for (sIt = staged.begin(); sIt != staged.end(); ++sIt)
+    {
+    ++directoryUses[sIt->Directory];
+    }
+  bool incremental = this->UseIncrementalStaging();
+  for (sIt = staged.begin(); sIt != staged.end(); ++sIt)
+    {
+    if (!sIt->ComponentInstall)
+      {
+      continue;
+      }
+    // A kept staging tree already holds the files of earlier runs, so
+    // the files added by this run are not all of the component.  Take
+    // the whole directory when the component owns it, or else what the
+    // component installed.
+    std::vector<std::string> files = sIt->FilesAdded;
+    if (incremental && directoryUses[sIt->Directory] == 1)
+      {
+      files = cmCPackGlobInstalledFiles(sIt->Directory);
+      }
+    else if (incremental)
+      {
+      std::vector<std::string> manifest =
+        cmCPackGetManifestFiles(*sIt);
+      files.insert(files.end(), manifest.begin(), manifest.end());
+      std::sort(files.begin(), files.end());
+      files.erase(std::unique(files.begin(), files.end()), files.end());
+      }
+    const char* InstallPrefix = sIt->Directory.c_str();
+    std::vector<std::string>::iterator fit;
+    std::string localFileName;
+    for (fit=files.begin();fit!=files.end();++fit)
+      {
+      localFileName =
+          cmSystemTools::RelativePath(InstallPrefix, fit->c_str());
+      localFileName =
+          localFileName.substr(localFileName.find('/')+1,
+                               std::string::npos);
+      Components[sIt->Component].Files.push_back(localFileName);
+      cmCPackLogger(cmCPackLog::LOG_DEBUG, "Adding file <"
+                          <<localFileName<<"> to component <"
+                          <<sIt->Component<<">"<<std::endl);
+      }
+    }
   this->SetOption("CPACK_ABSOLUTE_DESTINATION_FILES",
                   absoluteDestFiles.c_str());
   return 1;
 }
 
+//----------------------------------------------------------------------
+bool cmCPackGenerator::UpdateStagingManifest(
+  std::set<cmStdString> const& installed)
+{
+  std::string manifestFile = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
+  manifestFile += "/CPackStagingManifest.txt";
+  if (this->UseIncrementalStaging())
+    {
+    std::ifstream fin(manifestFile.c_str());
+    std::string line;
+    while (cmSystemTools::GetLineFromStream(fin, line))
+      {
+      if (!line.empty() && installed.find(line) == installed.end() &&
+          (cmSystemTools::FileExists(line.c_str()) ||
+           cmSystemTools::FileIsSymlink(line.c_str())))
+        {
+        cmCPackLogger(cmCPackLog::LOG_VERBOSE,
+                      "- Remove stale file: " << line << std::endl);
+        if (!cmSystemTools::RemoveFile(line.c_str()))
+          {
+          cmCPackLogger(cmCPackLog::LOG_ERROR,
+                        "Problem removing stale file: " << line
+                        << std::endl);
+          return false;
+          }
+        }
+      }
+    }
+  cmGeneratedFileStream fout(manifestFile.c_str());
+  for (std::set<cmStdString>::const_iterator i = installed.begin();
+       i != installed.end(); ++i)
+    {
+    fout << *i << "\n";
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------
+bool cmCPackGenerator::UseIncrementalStaging() const
+{
+  const char* commands = this->GetOption("CPACK_INSTALL_COMMANDS");
+  const char* script = this->GetOption("CPACK_INSTALL_SCRIPT");
+  const char* directories = this->GetOption("CPACK_INSTALLED_DIRECTORIES");
+  return this->IsOn("CPACK_INCREMENTAL_STAGING") &&
+    !(commands && *commands) && !(script && *script) &&
+    !(directories && *directories);
+}
+
 //----------------------------------------------------------------------
 bool cmCPackGenerator::ReadListFile(const char* moduleName)
 {
@@ -965,7 +1373,8 @@ int cmCPackGenerator::DoPackage()
     }
 
   if ( cmSystemTools::IsOn(
-      this->GetOption("CPACK_REMOVE_TOPLEVEL_DIRECTORY")) )
+      this->GetOption("CPACK_REMOVE_TOPLEVEL_DIRECTORY")) &&
+       !this->UseIncrementalStaging() )
     {
     const char* toplevelDirectory
       = this->GetOption("CPACK_TOPLEVEL_DIRECTORY");
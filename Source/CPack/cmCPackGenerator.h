@@ -16,6 +16,7 @@
 #include "cmObject.h"
 #include "cmSystemTools.h"
 #include <map>
+#include <set>
 #include <vector>
 
 #include "cmCPackComponentGroup.h" // cmCPackComponent and friends
@@ -120,6 +121,21 @@ protected:
 
   int CleanTemporaryDirectory();
 
+  /**
+   * Whether the staging tree of the previous run is kept and brought up
+   * to date instead of being installed from scratch.  This is requested
+   * with CPACK_INCREMENTAL_STAGING and only honored when the staging
+   * tree comes from CPACK_INSTALL_CMAKE_PROJECTS alone.
+   */
+  bool UseIncrementalStaging() const;
+
+  /**
+   * Record the files installed into the staging tree by this run and,
+   * with incremental staging, remove those a previous run installed
+   * that are no longer installed.
+   */
+  bool UpdateStagingManifest(std::set<cmStdString> const& installed);
+
   virtual const char* GetOutputExtension() { return ".cpack"; }
   virtual const char* GetOutputPostfix() { return 0; }
 
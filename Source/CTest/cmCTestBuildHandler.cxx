@@ -175,6 +175,120 @@ cmCTestWarningErrorFileLine[] = {
     { 0, 0, 0 }
 };
 
+//----------------------------------------------------------------------
+// Skip the bracket expression starting after its '['.  A leading ']'
+// is part of the set.
+static const char* cmCTestBuildSkipBracket(const char* p)
+{
+  if(*p == '^')
+    {
+    ++p;
+    }
+  if(*p == ']')
+    {
+    ++p;
+    }
+  while(*p && *p != ']')
+    {
+    ++p;
+    }
+  return *p? p + 1 : p;
+}
+
+//----------------------------------------------------------------------
+// Find the longest literal that every match of the regular expression
+// must contain.  This is conservative: an expression with top-level
+// alternation gives none, and groups, brackets and optional atoms end
+// a literal.
+static std::string cmCTestBuildRequiredLiteral(const char* rex)
+{
+  std::string best;
+  std::string run;
+  const char* p = rex;
+  while(*p)
+    {
+    const char* next = p + 1;
+    bool literal = false;
+    char c = *p;
+    if(c == '\\' && p[1])
+      {
+      c = p[1];
+      next = p + 2;
+      literal = true;
+      }
+    else if(c == '[')
+      {
+      next = cmCTestBuildSkipBracket(next);
+      }
+    else if(c == '(')
+      {
+      // Skip the group.
+      int depth = 1;
+      while(*next && depth > 0)
+        {
+        if(*next == '\\' && next[1])
+          {
+          ++next;
+          }
+        else if(*next == '[')
+          {
+          next = cmCTestBuildSkipBracket(next + 1);
+          continue;
+          }
+        else if(*next == '(')
+          {
+          ++depth;
+          }
+        else if(*next == ')')
+          {
+          --depth;
+          }
+        ++next;
+        }
+      }
+    else if(c == '|')
+      {
+      return std::string();
+      }
+    else if(!strchr(".^$)*+?", c))
+      {
+      literal = true;
+      }
+
+    if(*next == '*' || *next == '?')
+      {
+      // The atom is optional.
+      literal = false;
+      ++next;
+      }
+    else if(*next == '+' && literal)
+      {
+      // The atom appears at least once but may repeat.
+      run += c;
+      literal = false;
+      ++next;
+      }
+    if(literal)
+      {
+      run += c;
+      }
+    else
+      {
+      if(run.size() > best.size())
+        {
+        best = run;
+        }
+      run = "";
+      }
+    p = next;
+    }
+  if(run.size() > best.size())
+    {
+    best = run;
+    }
+  return best;
+}
+
 //----------------------------------------------------------------------
 cmCTestBuildHandler::cmCTestBuildHandler()
 {
@@ -210,7 +324,6 @@ void cmCTestBuildHandler::Initialize()
   this->BuildProcessingQueue.clear();
   this->BuildProcessingErrorQueue.clear();
   this->BuildOutputLogSize = 0;
-  this->CurrentProcessingLine.clear();
 
   this->SimplifySourceDir = "";
   this->SimplifyBuildDir = "";
@@ -400,8 +513,9 @@ int cmCTestBuildHandler::ProcessHandler()
   // Pre-compile regular expressions objects for all regular expressions
   std::vector<cmStdString>::iterator it;
 
-#define cmCTestBuildHandlerPopulateRegexVector(strings, regexes) \
+#define cmCTestBuildHandlerPopulateRegexVector(strings, regexes, literals) \
   regexes.clear(); \
+  literals.clear(); \
     cmCTestLog(this->CTest, DEBUG, this << "Add " #regexes \
     << std::endl); \
   for ( it = strings.begin(); it != strings.end(); ++it ) \
@@ -409,15 +523,20 @@ int cmCTestBuildHandler::ProcessHandler()
     cmCTestLog(this->CTest, DEBUG, "Add " #strings ": " \
     << it->c_str() << std::endl); \
     regexes.push_back(it->c_str()); \
+    literals.push_back(cmCTestBuildRequiredLiteral(it->c_str())); \
     }
   cmCTestBuildHandlerPopulateRegexVector(
-    this->CustomErrorMatches, this->ErrorMatchRegex);
+    this->CustomErrorMatches, this->ErrorMatchRegex,
+    this->ErrorMatchLiteral);
   cmCTestBuildHandlerPopulateRegexVector(
-    this->CustomErrorExceptions, this->ErrorExceptionRegex);
+    this->CustomErrorExceptions, this->ErrorExceptionRegex,
+    this->ErrorExceptionLiteral);
   cmCTestBuildHandlerPopulateRegexVector(
-    this->CustomWarningMatches, this->WarningMatchRegex);
+    this->CustomWarningMatches, this->WarningMatchRegex,
+    this->WarningMatchLiteral);
   cmCTestBuildHandlerPopulateRegexVector(
-    this->CustomWarningExceptions, this->WarningExceptionRegex);
+    this->CustomWarningExceptions, this->WarningExceptionRegex,
+    this->WarningExceptionLiteral);
 
 
   // Determine source and binary tree substitutions to simplify the output.
@@ -570,7 +689,7 @@ class cmCTestBuildHandler::FragmentCompare
 public:
   FragmentCompare(cmFileTimeComparison* ftc): FTC(ftc) {}
   FragmentCompare(): FTC(0) {}
-  bool operator()(std::string const& l, std::string const& r)
+  bool operator()(std::string const& l, std::string const& r) const
     {
     // Order files by modification time.  Use lexicographic order
     // among files with the same time.
@@ -622,6 +741,10 @@ void cmCTestBuildHandler::GenerateXMLLaunched(std::ostream& os)
       }
     }
 
+  // Copy the journaled fragments into the final XML file.
+  this->GenerateXMLLaunchedJournal(
+    os, (this->CTestLaunchDir + "/fragments.journal").c_str());
+
   // Copy the fragments into the final XML file.
   for(Fragments::const_iterator fi = fragments.begin();
       fi != fragments.end(); ++fi)
@@ -630,6 +753,170 @@ void cmCTestBuildHandler::GenerateXMLLaunched(std::ostream& os)
     }
 }
 
+//----------------------------------------------------------------------------
+// Journal records written by "ctest --launch" are a fixed-size header
+//   "CTLJ" <E|W> <32-char command hash> <8 hex digit length>
+// followed by the xml fragment itself.
+#define CM_CTEST_JOURNAL_HEADER_SIZE 45
+
+static bool cmCTestBuildReadJournalHeader(std::istream& fin, char& kind,
+                                          std::string& hash,
+                                          unsigned long& length)
+{
+  char header[CM_CTEST_JOURNAL_HEADER_SIZE+1];
+  if(!fin.read(header, CM_CTEST_JOURNAL_HEADER_SIZE) ||
+     strncmp(header, "CTLJ", 4) != 0 ||
+     (header[4] != 'E' && header[4] != 'W'))
+    {
+    return false;
+    }
+  header[CM_CTEST_JOURNAL_HEADER_SIZE] = 0;
+  char* end;
+  length = strtoul(header+37, &end, 16);
+  if(end != header+CM_CTEST_JOURNAL_HEADER_SIZE)
+    {
+    return false;
+    }
+  kind = header[4];
+  hash.assign(header+5, 32);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Find the next record header at or after the given offset, or return
+// the size of the journal if there is none.
+static unsigned long cmCTestBuildFindJournalRecord(std::istream& fin,
+                                                   unsigned long offset,
+                                                   unsigned long size)
+{
+  char buffer[8192];
+  while(offset < size)
+    {
+    unsigned long n = size - offset;
+    n = n < sizeof(buffer)? n : sizeof(buffer);
+    fin.clear();
+    fin.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    if(!fin.read(buffer, static_cast<std::streamsize>(n)))
+      {
+      break;
+      }
+    for(unsigned long i = 0; i + 4 <= n; ++i)
+      {
+      if(strncmp(buffer+i, "CTLJ", 4) == 0)
+        {
+        return offset + i;
+        }
+      }
+    if(offset + n >= size)
+      {
+      break;
+      }
+    // Keep the last bytes in case a header spans two reads.
+    offset += n - 3;
+    }
+  return size;
+}
+
+//----------------------------------------------------------------------------
+struct cmCTestBuildJournalRecord
+{
+  unsigned long Offset;
+  unsigned long Length;
+  char Kind;
+  bool Keep;
+};
+
+//----------------------------------------------------------------------------
+void cmCTestBuildHandler::GenerateXMLLaunchedJournal(std::ostream& os,
+                                                     const char* fname)
+{
+  std::ifstream fin(fname, std::ios::in | std::ios::binary);
+  if(!fin)
+    {
+    return;
+    }
+  fin.seekg(0, std::ios::end);
+  unsigned long size = static_cast<unsigned long>(fin.tellg());
+
+  // A command that ran more than once reports only its last result,
+  // just as its per-command fragment file would be replaced.  Scan
+  // the record headers to find the last record for each command.
+  // A record cut short by an interrupted launcher runs into the next
+  // one, so skip to the next header when a record is not followed by
+  // another or by the end of the journal.
+  std::map<cmStdString, size_t> lastRecord;
+  std::vector<cmCTestBuildJournalRecord> records;
+  char kind;
+  std::string hash;
+  unsigned long length;
+  unsigned long offset = 0;
+  while(offset + CM_CTEST_JOURNAL_HEADER_SIZE <= size)
+    {
+    fin.clear();
+    fin.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    bool valid = (cmCTestBuildReadJournalHeader(fin, kind, hash, length) &&
+                  length <= size - offset - CM_CTEST_JOURNAL_HEADER_SIZE);
+    unsigned long end = offset + CM_CTEST_JOURNAL_HEADER_SIZE + length;
+    if(valid && end + 4 <= size)
+      {
+      char magic[4];
+      fin.seekg(static_cast<std::streamoff>(end), std::ios::beg);
+      valid = (fin.read(magic, 4) && strncmp(magic, "CTLJ", 4) == 0);
+      }
+    if(!valid)
+      {
+      offset = cmCTestBuildFindJournalRecord(fin, offset + 1, size);
+      continue;
+      }
+    std::map<cmStdString, size_t>::iterator li = lastRecord.find(hash);
+    if(li != lastRecord.end())
+      {
+      records[li->second].Keep = false;
+      li->second = records.size();
+      }
+    else
+      {
+      lastRecord[hash] = records.size();
+      }
+    cmCTestBuildJournalRecord record;
+    record.Offset = offset + CM_CTEST_JOURNAL_HEADER_SIZE;
+    record.Length = length;
+    record.Kind = kind;
+    record.Keep = true;
+    records.push_back(record);
+    offset = end;
+    }
+
+  // Stream the surviving records into the final XML file.
+  char buffer[8192];
+  for(std::vector<cmCTestBuildJournalRecord>::const_iterator ri =
+        records.begin(); ri != records.end(); ++ri)
+    {
+    if(!ri->Keep)
+      {
+      continue;
+      }
+    if(ri->Kind == 'E')
+      {
+      ++this->TotalErrors;
+      }
+    else
+      {
+      ++this->TotalWarnings;
+      }
+    fin.clear();
+    fin.seekg(static_cast<std::streamoff>(ri->Offset), std::ios::beg);
+    length = ri->Length;
+    while(length > 0)
+      {
+      unsigned long n = length < sizeof(buffer)? length : sizeof(buffer);
+      fin.read(buffer, static_cast<std::streamsize>(n));
+      os.write(buffer, static_cast<std::streamsize>(n));
+      length -= n;
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void cmCTestBuildHandler::GenerateXMLLogScraped(std::ostream& os)
 {
@@ -1052,27 +1339,20 @@ void cmCTestBuildHandler::ProcessBuffer(const char* data, int length,
   t_BuildProcessingQueueType* queue)
 {
   const std::string::size_type tick_line_len = 50;
-  const char* ptr;
-  for ( ptr = data; ptr < data+length; ptr ++ )
+  if ( length > 0 )
     {
-    queue->push_back(*ptr);
+    queue->append(data, length);
     }
   this->BuildOutputLogSize += length;
 
   // until there are any lines left in the buffer
-  while ( 1 )
+  std::string::size_type start = 0;
+  while ( start < queue->size() )
     {
     // Find the end of line
-    t_BuildProcessingQueueType::iterator it;
-    for ( it = queue->begin();
-      it != queue->end();
-      ++ it )
-      {
-      if ( *it == '\n' )
-        {
-        break;
-        }
-      }
+    char* begin = &(*queue)[start];
+    char* end = static_cast<char*>(
+      memchr(begin, '\n', queue->size() - start));
 
     // Once certain number of errors or warnings reached, ignore future errors
     // or warnings.
@@ -1086,23 +1366,17 @@ void cmCTestBuildHandler::ProcessBuffer(const char* data, int length,
       }
 
     // If the end of line was found
-    if ( it != queue->end() )
+    if ( end )
       {
-      // Create a contiguous array for the line
-      this->CurrentProcessingLine.clear();
-      t_BuildProcessingQueueType::iterator cit;
-      for ( cit = queue->begin(); cit != it; ++cit )
-        {
-        this->CurrentProcessingLine.push_back(*cit);
-        }
-      this->CurrentProcessingLine.push_back(0);
-      const char* line = &*this->CurrentProcessingLine.begin();
+      // Terminate the line in place
+      *end = 0;
+      const char* line = begin;
 
       // Process the line
       int lineType = this->ProcessSingleLine(line);
 
-      // Erase the line from the queue
-      queue->erase(queue->begin(), it+1);
+      // Skip the line in the queue
+      start += (end - begin) + 1;
 
       // Depending on the line type, produce error or warning, or nothing
       cmCTestBuildErrorWarning errorwarning;
@@ -1178,6 +1452,8 @@ void cmCTestBuildHandler::ProcessBuffer(const char* data, int length,
       break;
       }
     }
+  // Erase the processed lines from the queue
+  queue->erase(0, start);
 
   // Now that the buffer is processed, display missing ticks
   int tickDisplayed = false;
@@ -1217,83 +1493,67 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
 
   cmCTestLog(this->CTest, DEBUG, "Line: [" << data << "]" << std::endl);
 
-  std::vector<cmsys::RegularExpression>::iterator it;
-
   int warningLine = 0;
   int errorLine = 0;
 
+  // Note the characters present in the line once for all expressions.
+  char present[256];
+  memset(present, 0, sizeof(present));
+  for(const unsigned char* c = reinterpret_cast<const unsigned char*>(data);
+      *c; ++c)
+    {
+    present[*c] = 1;
+    }
+
   // Check for regular expressions
 
   if ( !this->ErrorQuotaReached )
     {
     // Errors
-    int wrxCnt = 0;
-    for ( it = this->ErrorMatchRegex.begin();
-      it != this->ErrorMatchRegex.end();
-      ++ it )
-      {
-      if ( it->find(data) )
-        {
-        errorLine = 1;
-        cmCTestLog(this->CTest, DEBUG, "  Error Line: " << data
-          << " (matches: " << this->CustomErrorMatches[wrxCnt] << ")"
-          << std::endl);
-        break;
-        }
-      wrxCnt ++;
-      }
-    // Error exceptions
-    wrxCnt = 0;
-    for ( it = this->ErrorExceptionRegex.begin();
-      it != this->ErrorExceptionRegex.end();
-      ++ it )
+    int match = this->MatchLine(data, present, this->ErrorMatchRegex,
+                                this->ErrorMatchLiteral);
+    if ( match >= 0 )
       {
-      if ( it->find(data) )
+      errorLine = 1;
+      cmCTestLog(this->CTest, DEBUG, "  Error Line: " << data
+        << " (matches: " << this->CustomErrorMatches[match] << ")"
+        << std::endl);
+
+      // Error exceptions
+      match = this->MatchLine(data, present, this->ErrorExceptionRegex,
+                              this->ErrorExceptionLiteral);
+      if ( match >= 0 )
         {
         errorLine = 0;
         cmCTestLog(this->CTest, DEBUG, "  Not an error Line: " << data
-          << " (matches: " << this->CustomErrorExceptions[wrxCnt] << ")"
+          << " (matches: " << this->CustomErrorExceptions[match] << ")"
           << std::endl);
-        break;
         }
-      wrxCnt ++;
       }
     }
-  if ( !this->WarningQuotaReached )
+  if ( !this->WarningQuotaReached && !errorLine )
     {
     // Warnings
-    int wrxCnt = 0;
-    for ( it = this->WarningMatchRegex.begin();
-      it != this->WarningMatchRegex.end();
-      ++ it )
+    int match = this->MatchLine(data, present, this->WarningMatchRegex,
+                                this->WarningMatchLiteral);
+    if ( match >= 0 )
       {
-      if ( it->find(data) )
-        {
-        warningLine = 1;
-        cmCTestLog(this->CTest, DEBUG,
-          "  Warning Line: " << data
-          << " (matches: " << this->CustomWarningMatches[wrxCnt] << ")"
-          << std::endl);
-        break;
-        }
-      wrxCnt ++;
-      }
-
-    wrxCnt = 0;
-    // Warning exceptions
-    for ( it = this->WarningExceptionRegex.begin();
-      it != this->WarningExceptionRegex.end();
-      ++ it )
-      {
-      if ( it->find(data) )
+      warningLine = 1;
+      cmCTestLog(this->CTest, DEBUG,
+        "  Warning Line: " << data
+        << " (matches: " << this->CustomWarningMatches[match] << ")"
+        << std::endl);
+
+      // Warning exceptions
+      match = this->MatchLine(data, present, this->WarningExceptionRegex,
+                              this->WarningExceptionLiteral);
+      if ( match >= 0 )
         {
         warningLine = 0;
         cmCTestLog(this->CTest, DEBUG, "  Not a warning Line: " << data
-          << " (matches: " << this->CustomWarningExceptions[wrxCnt] << ")"
+          << " (matches: " << this->CustomWarningExceptions[match] << ")"
           << std::endl);
-        break;
         }
-      wrxCnt ++;
       }
     }
   if ( errorLine )
@@ -1307,3 +1567,26 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
   return b_REGULAR_LINE;
 }
 
+//----------------------------------------------------------------------
+int cmCTestBuildHandler::MatchLine(const char* data, const char* present,
+  std::vector<cmsys::RegularExpression>& regexes,
+  std::vector<std::string> const& literals)
+{
+  for(size_t i = 0; i < regexes.size(); ++i)
+    {
+    // Skip the expression if the line lacks its required literal.
+    std::string const& literal = literals[i];
+    bool possible = true;
+    for(std::string::const_iterator c = literal.begin();
+        possible && c != literal.end(); ++c)
+      {
+      possible = present[static_cast<unsigned char>(*c)] != 0;
+      }
+    if(possible && (literal.size() < 2 || strstr(data, literal.c_str())) &&
+       regexes[i].find(data))
+      {
+      return static_cast<int>(i);
+      }
+    }
+  return -1;
+}
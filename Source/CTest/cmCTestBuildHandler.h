@@ -89,6 +89,7 @@ private:
   void GenerateXMLLogScraped(std::ostream& os);
   void GenerateXMLFooter(std::ostream& os, double elapsed_build_time);
   void GenerateXMLLaunchedFragment(std::ostream& os, const char* fname);
+  void GenerateXMLLaunchedJournal(std::ostream& os, const char* fname);
   bool IsLaunchedErrorFile(const char* fname);
   bool IsLaunchedWarningFile(const char* fname);
 
@@ -110,16 +111,28 @@ private:
   std::vector<cmsys::RegularExpression> WarningMatchRegex;
   std::vector<cmsys::RegularExpression> WarningExceptionRegex;
 
-  typedef std::deque<char> t_BuildProcessingQueueType;
+  // A literal every match of the corresponding regular expression
+  // contains, or empty if none was found.  Lines lacking a character
+  // of it are not run through the expression.
+  std::vector<std::string> ErrorMatchLiteral;
+  std::vector<std::string> ErrorExceptionLiteral;
+  std::vector<std::string> WarningMatchLiteral;
+  std::vector<std::string> WarningExceptionLiteral;
+
+  // Output not yet processed, kept contiguous so lines can be split
+  // with memchr and handed on in place.
+  typedef std::string t_BuildProcessingQueueType;
 
   void ProcessBuffer(const char* data, int length, size_t& tick,
     size_t tick_len, std::ofstream& ofs, t_BuildProcessingQueueType* queue);
   int ProcessSingleLine(const char* data);
+  int MatchLine(const char* data, const char* present,
+                std::vector<cmsys::RegularExpression>& regexes,
+                std::vector<std::string> const& literals);
 
   t_BuildProcessingQueueType            BuildProcessingQueue;
   t_BuildProcessingQueueType            BuildProcessingErrorQueue;
   size_t                                BuildOutputLogSize;
-  std::vector<char>                     CurrentProcessingLine;
 
   cmStdString                           SimplifySourceDir;
   cmStdString                           SimplifyBuildDir;
@@ -117,6 +117,16 @@ public:
       return this->PipeState;
     }
   int GetProcessState() { return this->PipeState;}
+  int GetState() { return cmsysProcess_GetState(this->Process); }
+  int GetExitValue() { return cmsysProcess_GetExitValue(this->Process); }
+  const char* GetErrorString()
+    {
+    return cmsysProcess_GetErrorString(this->Process);
+    }
+  const char* GetExceptionString()
+    {
+    return cmsysProcess_GetExceptionString(this->Process);
+    }
 private:
   int PipeState;
   cmsysProcess* Process;
@@ -125,12 +135,335 @@ private:
   double TimeOut;
 };
 
+//----------------------------------------------------------------------
+// Runs gcov on a list of coverage data files with up to a fixed number of
+// invocations in flight.  Results are handed back strictly in list order.
+// gcov writes its .gcov files into the current directory and different
+// objects commonly produce the same .gcov names, so every concurrent run
+// gets its own working directory.
+class cmCTestGCovQueue
+{
+public:
+  cmCTestGCovQueue(std::vector<std::string> const& commands,
+                   std::string const& tempDir, size_t maxJobs):
+    Commands(commands), TempDir(tempDir), MaxJobs(maxJobs), NextJob(0)
+    {
+    if(this->MaxJobs < 1)
+      {
+      this->MaxJobs = 1;
+      }
+    }
+  ~cmCTestGCovQueue()
+    {
+    while(!this->Jobs.empty())
+      {
+      this->Jobs.front()->Process.WaitForExit();
+      this->FinishJob(this->Jobs.front());
+      this->Jobs.pop_front();
+      }
+    if(this->MaxJobs > 1)
+      {
+      for(size_t slot = 0; slot < this->MaxJobs; ++slot)
+        {
+        cmSystemTools::RemoveADirectory(this->GetSlotDir(slot).c_str());
+        }
+      }
+    }
+
+  // Wait for the next command in list order and return its results in
+  // the same form as cmCTest::RunCommand.  The directory in which gcov
+  // wrote its .gcov files is stored in dir.
+  bool Next(std::string& output, std::string& errors, int& retVal,
+            std::string& dir)
+    {
+    while(this->NextJob < this->Commands.size() &&
+          this->Jobs.size() < this->MaxJobs)
+      {
+      this->StartJob(this->NextJob++);
+      }
+    if(this->Jobs.empty())
+      {
+      return false;
+      }
+    Job* job = this->Jobs.front();
+    this->Jobs.pop_front();
+    job->Process.WaitForExit();
+
+    bool result = true;
+    output = this->ReadFile(job->OutputFile);
+    errors = this->ReadFile(job->ErrorFile);
+    retVal = 0;
+    switch(job->Started? job->Process.GetState() : cmsysProcess_State_Error)
+      {
+      case cmsysProcess_State_Exited:
+        retVal = job->Process.GetExitValue();
+        break;
+      case cmsysProcess_State_Exception:
+        errors += job->Process.GetExceptionString();
+        result = false;
+        break;
+      case cmsysProcess_State_Error:
+        errors += job->Process.GetErrorString();
+        result = false;
+        break;
+      default:
+        errors += "Process terminated unexpectedly\n";
+        result = false;
+        break;
+      }
+    dir = job->Directory;
+    this->FinishJob(job);
+    return result;
+    }
+
+private:
+  struct Job
+  {
+    cmCTestRunProcess Process;
+    std::string Directory;
+    std::string OutputFile;
+    std::string ErrorFile;
+    bool Started;
+  };
+
+  std::string GetSlotDir(size_t slot)
+    {
+    if(this->MaxJobs == 1)
+      {
+      return this->TempDir;
+      }
+    cmOStringStream dir;
+    dir << this->TempDir << "/gcov" << slot;
+    return dir.str();
+    }
+
+  void StartJob(size_t index)
+    {
+    // A slot is only reused after the job that last used it has been
+    // handed back, so its directory may be cleared here.
+    size_t slot = index % this->MaxJobs;
+    Job* job = new Job;
+    job->Directory = this->GetSlotDir(slot);
+    if(this->MaxJobs > 1)
+      {
+      cmSystemTools::RemoveADirectory(job->Directory.c_str());
+      cmSystemTools::MakeDirectory(job->Directory.c_str());
+      }
+    cmOStringStream out;
+    out << this->TempDir << "/gcov" << slot;
+    job->OutputFile = out.str() + ".out";
+    job->ErrorFile = out.str() + ".err";
+
+    std::vector<cmStdString> args =
+      cmSystemTools::ParseArguments(this->Commands[index].c_str());
+    for(std::vector<cmStdString>::const_iterator a = args.begin();
+        a != args.end(); ++a)
+      {
+      if(a == args.begin())
+        {
+        job->Process.SetCommand(a->c_str());
+        }
+      else
+        {
+        job->Process.AddArgument(a->c_str());
+        }
+      }
+    job->Process.SetWorkingDirectory(job->Directory.c_str());
+    job->Process.SetStdoutFile(job->OutputFile.c_str());
+    job->Process.SetStderrFile(job->ErrorFile.c_str());
+    job->Started = !args.empty() && job->Process.StartProcess();
+    this->Jobs.push_back(job);
+    }
+
+  void FinishJob(Job* job)
+    {
+    cmSystemTools::RemoveFile(job->OutputFile.c_str());
+    cmSystemTools::RemoveFile(job->ErrorFile.c_str());
+    delete job;
+    }
+
+  std::string ReadFile(std::string const& fname)
+    {
+    std::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
+    cmOStringStream content;
+    if(fin)
+      {
+      content << fin.rdbuf();
+      }
+    return content.str();
+    }
+
+  std::vector<std::string> const& Commands;
+  std::string TempDir;
+  size_t MaxJobs;
+  size_t NextJob;
+  std::deque<Job*> Jobs;
+};
+
+
+//----------------------------------------------------------------------
+static void cmCTestCoverageRemoveSpillFiles(
+  std::vector<std::string> const& files)
+{
+  for(std::vector<std::string>::const_iterator f = files.begin();
+      f != files.end(); ++f)
+    {
+    cmSystemTools::RemoveFile(f->c_str());
+    }
+}
+
+// At most this many spill files are kept.  Once there are more they are
+// merged into one so that reading them back never opens more files.
+#define CM_CTEST_COVERAGE_MAX_SPILL_FILES 16
+
+//----------------------------------------------------------------------
+// Reads back the coverage vectors written by SpillCoverage.  Each spill
+// file holds records sorted by source file name, so all of them are
+// merged in a single pass while the results are written in the same
+// order.
+class cmCTestCoverageSpillReader
+{
+public:
+  typedef cmCTestCoverageHandlerContainer::SingleFileCoverageVector
+    SingleFileCoverageVector;
+
+  cmCTestCoverageSpillReader(std::vector<std::string> const& files):
+    Files(files)
+    {
+    for(std::vector<std::string>::const_iterator f = files.begin();
+        f != files.end() && this->FailedFile.empty(); ++f)
+      {
+      Run* run = new Run;
+      run->File = *f;
+      run->Stream.open(f->c_str());
+      this->Runs.push_back(run);
+      if(!run->Stream)
+        {
+        run->Valid = false;
+        this->FailedFile = *f;
+        break;
+        }
+      this->Advance(*run);
+      }
+    }
+  ~cmCTestCoverageSpillReader()
+    {
+    for(std::vector<Run*>::iterator r = this->Runs.begin();
+        r != this->Runs.end(); ++r)
+      {
+      delete *r;
+      }
+    cmCTestCoverageRemoveSpillFiles(this->Files);
+    }
+
+  // The spill file that could not be opened or parsed, if any.
+  std::string const& GetFailedFile() const { return this->FailedFile; }
+
+  // Get the first source file name not yet merged.
+  bool NextName(std::string& name) const
+    {
+    bool found = false;
+    for(std::vector<Run*>::const_iterator r = this->Runs.begin();
+        r != this->Runs.end(); ++r)
+      {
+      if((*r)->Valid && (!found || (*r)->Name < name))
+        {
+        name = (*r)->Name;
+        found = true;
+        }
+      }
+    return found;
+    }
+
+  // Add all spilled coverage of the given source file to vec.  Records
+  // for files that sort before it were skipped by the caller.
+  void Merge(std::string const& name, SingleFileCoverageVector& vec)
+    {
+    for(std::vector<Run*>::iterator r = this->Runs.begin();
+        r != this->Runs.end(); ++r)
+      {
+      Run& run = **r;
+      while(run.Valid && run.Name < name)
+        {
+        this->Advance(run);
+        }
+      while(run.Valid && run.Name == name)
+        {
+        if(vec.size() < run.Counts.size())
+          {
+          vec.resize(run.Counts.size(), -1);
+          }
+        for(size_t i = 0; i < run.Counts.size(); ++i)
+          {
+          // Negative entries mark lines without coverage information.
+          if(run.Counts[i] >= 0)
+            {
+            vec[i] = (vec[i] < 0)? run.Counts[i] : vec[i] + run.Counts[i];
+            }
+          }
+        this->Advance(run);
+        }
+      }
+    }
+
+private:
+  struct Run
+  {
+    std::string File;
+    std::ifstream Stream;
+    std::string Name;
+    SingleFileCoverageVector Counts;
+    bool Valid;
+  };
+
+  void Advance(Run& run)
+    {
+    run.Valid = false;
+    if(!cmSystemTools::GetLineFromStream(run.Stream, run.Name))
+      {
+      return;
+      }
+    size_t size = 0;
+    run.Stream >> size;
+    run.Counts.resize(size);
+    for(size_t i = 0; i < size; ++i)
+      {
+      run.Stream >> run.Counts[i];
+      }
+    // Skip the end of the counts line.
+    std::string rest;
+    cmSystemTools::GetLineFromStream(run.Stream, rest);
+    run.Valid = !run.Stream.fail();
+    if(!run.Valid && this->FailedFile.empty())
+      {
+      this->FailedFile = run.File;
+      }
+    }
+
+  std::vector<std::string> const& Files;
+  std::vector<Run*> Runs;
+  std::string FailedFile;
+};
+
+//----------------------------------------------------------------------
+static void cmCTestCoverageWriteSpillRecord(std::ostream& fout,
+  std::string const& name,
+  cmCTestCoverageHandlerContainer::SingleFileCoverageVector const& vec)
+{
+  fout << name << "\n" << vec.size();
+  for ( size_t cc = 0; cc < vec.size(); ++cc )
+    {
+    fout << " " << vec[cc];
+    }
+  fout << "\n";
+}
 
 //----------------------------------------------------------------------
 
 //----------------------------------------------------------------------
 cmCTestCoverageHandler::cmCTestCoverageHandler()
 {
+  this->CoverageMemoryLimit = 0;
 }
 
 //----------------------------------------------------------------------
@@ -142,6 +475,7 @@ void cmCTestCoverageHandler::Initialize()
   this->LabelIdMap.clear();
   this->Labels.clear();
   this->LabelFilter.clear();
+  this->CoverageMemoryLimit = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -355,6 +689,9 @@ int cmCTestCoverageHandler::ProcessHandler()
   cont.SourceDir = sourceDir;
   cont.BinaryDir = binaryDir;
   cont.OFS = &ofs;
+  cont.LinesInMemory = 0;
+  cont.SpillFileCount = 0;
+  cont.SpillFailed = false;
 
   // setup the regex exclude stuff
   this->CustomCoverageExcludeRegex.clear();
@@ -387,6 +724,12 @@ int cmCTestCoverageHandler::ProcessHandler()
     {
     return error;
     }
+  if ( cont.SpillFailed )
+    {
+    // Coverage moved to disk has been lost.
+    cmCTestCoverageRemoveSpillFiles(cont.SpillFiles);
+    return -1;
+    }
   error = cont.Error;
 
   std::set<std::string> uncovered = this->FindUncoveredFiles(&cont);
@@ -434,6 +777,13 @@ int cmCTestCoverageHandler::ProcessHandler()
 
   std::vector<std::string> errorsWhileAccumulating;
 
+  cmCTestCoverageSpillReader spillReader(cont.SpillFiles);
+  if ( !spillReader.GetFailedFile().empty() )
+    {
+    cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot read coverage file: "
+      << spillReader.GetFailedFile() << std::endl);
+    return -1;
+    }
   file_count = 0;
   for ( fileIterator = cont.TotalCoverage.begin();
     fileIterator != cont.TotalCoverage.end();
@@ -486,8 +836,11 @@ int cmCTestCoverageHandler::ProcessHandler()
       = cmSystemTools::GetFilenameName(fullFileName.c_str());
     std::string shortFileName =
       this->CTest->GetShortPathToFile(fullFileName.c_str());
-    const cmCTestCoverageHandlerContainer::SingleFileCoverageVector& fcov
-      = fileIterator->second;
+    // Take the coverage out of the map so that memory is released as
+    // soon as this file has been written.
+    cmCTestCoverageHandlerContainer::SingleFileCoverageVector fcov;
+    fcov.swap(fileIterator->second);
+    spillReader.Merge(fullFileName, fcov);
     covLogFile << "\t<File Name=\"" << cmXMLSafe(fileName)
       << "\" FullPath=\"" << cmXMLSafe(shortFileName) << "\">\n"
       << "\t\t<Report>" << std::endl;
@@ -570,6 +923,13 @@ int cmCTestCoverageHandler::ProcessHandler()
     covSumFile << "\t</File>" << std::endl;
     }
 
+  if ( !spillReader.GetFailedFile().empty() )
+    {
+    cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot read coverage file: "
+      << spillReader.GetFailedFile() << std::endl);
+    return -1;
+    }
+
   //Handle all the files in the extra coverage globs that have no cov data
   for(std::set<std::string>::iterator i = uncovered.begin();
       i != uncovered.end(); ++i)
@@ -693,6 +1053,8 @@ void cmCTestCoverageHandler::PopulateCustomVectors(cmMakefile *mf)
                                 this->CustomCoverageExclude);
   this->CTest->PopulateCustomVector(mf, "CTEST_EXTRA_COVERAGE_GLOB",
                                 this->ExtraCoverageGlobs);
+  this->CTest->PopulateCustomInteger(mf, "CTEST_CUSTOM_COVERAGE_MEMORY_LIMIT",
+                                     this->CoverageMemoryLimit);
   std::vector<cmStdString>::iterator it;
   for ( it = this->CustomCoverageExclude.begin();
     it != this->CustomCoverageExclude.end();
@@ -821,6 +1183,22 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
   // These are binary files that you give as input to gcov so that it will
   // give us text output we can analyze to summarize coverage.
   //
+  std::vector<std::string> commands;
+  for ( it = files.begin(); it != files.end(); ++ it )
+    {
+    std::string fileDir = cmSystemTools::GetFilenamePath(it->c_str());
+    commands.push_back("\"" + gcovCommand + "\" " +
+      gcovExtraFlags + " " +
+      "-o \"" + fileDir + "\" " +
+      "\"" + *it + "\"");
+    }
+
+  // Run as many gcov processes at once as ctest runs tests.  The output
+  // is still processed one file at a time in the order found above.
+  int parallelLevel = this->CTest->GetParallelLevel();
+  cmCTestGCovQueue gcovQueue(commands, tempDir,
+    parallelLevel > 1 ? static_cast<size_t>(parallelLevel) : 1);
+
   for ( it = files.begin(); it != files.end(); ++ it )
     {
     cmCTestLog(this->CTest, HANDLER_OUTPUT, "." << std::flush);
@@ -828,21 +1206,18 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
     // Call gcov to get coverage data for this *.gcda file:
     //
     std::string fileDir = cmSystemTools::GetFilenamePath(it->c_str());
-    std::string command = "\"" + gcovCommand + "\" " +
-      gcovExtraFlags + " " +
-      "-o \"" + fileDir + "\" " +
-      "\"" + *it + "\"";
+    std::string const& command = commands[it - files.begin()];
 
     cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT, command.c_str()
       << std::endl);
 
     std::string output = "";
     std::string errors = "";
+    std::string gcovDir = "";
     int retVal = 0;
     *cont->OFS << "* Run coverage for: " << fileDir.c_str() << std::endl;
     *cont->OFS << "  Command: " << command.c_str() << std::endl;
-    int res = this->CTest->RunCommand(command.c_str(), &output, &errors,
-      &retVal, tempDir.c_str(), 0 /*this->TimeOut*/);
+    int res = gcovQueue.Next(output, errors, retVal, gcovDir);
 
     *cont->OFS << "  Output: " << output.c_str() << std::endl;
     *cont->OFS << "  Errors: " << errors.c_str() << std::endl;
@@ -1038,7 +1413,9 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
         cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT, "   in gcovFile: "
           << gcovFile << std::endl);
 
-        std::ifstream ifile(gcovFile.c_str());
+        std::string gcovPath =
+          cmSystemTools::CollapseFullPath(gcovFile.c_str(), gcovDir.c_str());
+        std::ifstream ifile(gcovPath.c_str());
         if ( ! ifile )
           {
           cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot open file: "
@@ -1046,6 +1423,7 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
           }
         else
           {
+          size_t oldSize = vec.size();
           long cnt = -1;
           std::string nl;
           while ( cmSystemTools::GetLineFromStream(ifile, nl) )
@@ -1096,6 +1474,7 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
               vec[lineIdx] += cov;
               }
             }
+          cont->LinesInMemory += vec.size() - oldSize;
           }
 
         actualSourceFile = "";
@@ -1156,6 +1535,7 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
       }
 
     file_count++;
+    this->SpillCoverage(cont);
 
     if ( file_count % 50 == 0 )
       {
@@ -1169,6 +1549,99 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
   return file_count;
 }
 
+//----------------------------------------------------------------------
+void cmCTestCoverageHandler::SpillCoverage(
+  cmCTestCoverageHandlerContainer* cont)
+{
+  // The limit is given in megabytes.
+  if ( this->CoverageMemoryLimit <= 0 ||
+    cont->LinesInMemory * sizeof(int) <
+    static_cast<size_t>(this->CoverageMemoryLimit) * 1024 * 1024 )
+    {
+    return;
+    }
+
+  if ( cont->SpillFiles.size() >= CM_CTEST_COVERAGE_MAX_SPILL_FILES )
+    {
+    this->MergeSpillFiles(cont);
+    }
+
+  std::string fname = this->GetSpillFileName(cont);
+  std::ofstream fout(fname.c_str());
+  if ( !fout )
+    {
+    cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot create file: "
+      << fname << std::endl);
+    return;
+    }
+  cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+    "   Moving coverage of " << cont->LinesInMemory << " lines to "
+    << fname << std::endl);
+
+  // The map is sorted by file name so every spill file is too.
+  cmCTestCoverageHandlerContainer::TotalCoverageMap::iterator i;
+  for ( i = cont->TotalCoverage.begin(); i != cont->TotalCoverage.end(); ++i )
+    {
+    if ( i->second.empty() )
+      {
+      continue;
+      }
+    cmCTestCoverageWriteSpillRecord(fout, i->first, i->second);
+    cmCTestCoverageHandlerContainer::SingleFileCoverageVector().swap(
+      i->second);
+    }
+  cont->SpillFiles.push_back(fname);
+  cont->LinesInMemory = 0;
+}
+
+//----------------------------------------------------------------------
+std::string cmCTestCoverageHandler::GetSpillFileName(
+  cmCTestCoverageHandlerContainer* cont)
+{
+  cmOStringStream fname;
+  fname << this->CTest->GetBinaryDir() << "/Testing/CoverageInfo/"
+    << "CoverageSpill" << cont->SpillFileCount++ << ".txt";
+  return fname.str();
+}
+
+//----------------------------------------------------------------------
+void cmCTestCoverageHandler::MergeSpillFiles(
+  cmCTestCoverageHandlerContainer* cont)
+{
+  std::string fname = this->GetSpillFileName(cont);
+  std::ofstream fout(fname.c_str());
+  if ( !fout )
+    {
+    cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot create file: "
+      << fname << std::endl);
+    cont->SpillFailed = true;
+    return;
+    }
+  cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+    "   Merging " << cont->SpillFiles.size() << " coverage files into "
+    << fname << std::endl);
+
+  // The reader removes the merged files when it is done.
+  std::vector<std::string> files;
+  files.swap(cont->SpillFiles);
+  cmCTestCoverageSpillReader reader(files);
+  std::string name;
+  cmCTestCoverageHandlerContainer::SingleFileCoverageVector vec;
+  while ( reader.GetFailedFile().empty() && reader.NextName(name) )
+    {
+    vec.clear();
+    reader.Merge(name, vec);
+    cmCTestCoverageWriteSpillRecord(fout, name, vec);
+    }
+  if ( !reader.GetFailedFile().empty() )
+    {
+    cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot read coverage file: "
+      << reader.GetFailedFile() << std::endl);
+    cont->SpillFailed = true;
+    }
+  cont->SpillFiles.push_back(fname);
+}
+
 //----------------------------------------------------------------------------
 void cmCTestCoverageHandler::FindGCovFiles(std::vector<std::string>& files)
 {
@@ -30,6 +30,13 @@ public:
   typedef std::map<std::string, SingleFileCoverageVector> TotalCoverageMap;
   TotalCoverageMap TotalCoverage;
   std::ostream* OFS;
+
+  // Coverage vectors moved to disk to bound memory use.  A spilled file
+  // keeps its entry in TotalCoverage with an empty vector.
+  std::vector<std::string> SpillFiles;
+  int SpillFileCount;
+  bool SpillFailed;
+  size_t LinesInMemory;
 };
 /** \class cmCTestCoverageHandler
  * \brief A class that handles coverage computaiton for ctest
@@ -68,6 +75,11 @@ private:
   int HandleGCovCoverage(cmCTestCoverageHandlerContainer* cont);
   void FindGCovFiles(std::vector<std::string>& files);
 
+  //! Move coverage vectors to disk when they exceed the memory limit
+  void SpillCoverage(cmCTestCoverageHandlerContainer* cont);
+  void MergeSpillFiles(cmCTestCoverageHandlerContainer* cont);
+  std::string GetSpillFileName(cmCTestCoverageHandlerContainer* cont);
+
   //! Handle coverage using xdebug php coverage
   int HandlePHPCoverage(cmCTestCoverageHandlerContainer* cont);
 
@@ -109,6 +121,7 @@ private:
   std::vector<cmStdString> CustomCoverageExclude;
   std::vector<cmsys::RegularExpression> CustomCoverageExcludeRegex;
   std::vector<cmStdString> ExtraCoverageGlobs;
+  int CoverageMemoryLimit;
 
 
   // Map from source file to label ids.
@@ -63,6 +63,26 @@ private:
     }
 };
 
+//----------------------------------------------------------------------------
+class cmCTestGIT::CountParser: public cmCTestVC::LineParser
+{
+public:
+  CountParser(cmCTestGIT* git, const char* prefix): Count(0)
+    {
+    this->SetLog(&git->Log, prefix);
+    }
+  unsigned long Count;
+private:
+  virtual bool ProcessLine()
+    {
+    if(!this->Line.empty())
+      {
+      ++this->Count;
+      }
+    return true;
+    }
+};
+
 //----------------------------------------------------------------------------
 std::string cmCTestGIT::GetWorkingRevision()
 {
@@ -601,9 +621,31 @@ char const cmCTestGIT::CommitParser::SectionSep[SectionCount] =
 //----------------------------------------------------------------------------
 void cmCTestGIT::LoadRevisions()
 {
-  // Use 'git rev-list ... | git diff-tree ...' to get revisions.
   std::string range = this->OldRevision + ".." + this->NewRevision;
   const char* git = this->CommandLineTool.c_str();
+
+  // Very large updates are summarized by a single tree diff instead
+  // of walking every revision.  Stop counting just past the limit.
+  unsigned long limit = strtoul(
+    this->CTest->GetCTestConfiguration("GITUpdateRevisionLimit").c_str(),
+    0, 10);
+  if(limit > 0)
+    {
+    char max_count[64];
+    sprintf(max_count, "--max-count=%lu", limit+1);
+    const char* git_rev_count[] =
+      {git, "rev-list", max_count, range.c_str(), "--", 0};
+    CountParser out(this, "rc-out> ");
+    OutputLogger err(this->Log, "rc-err> ");
+    this->RunChild(git_rev_count, &out, &err);
+    if(out.Count > limit)
+      {
+      this->LoadRevisionSummary(out.Count, limit);
+      return;
+      }
+    }
+
+  // Use 'git rev-list ... | git diff-tree ...' to get revisions.
   const char* git_rev_list[] =
     {git, "rev-list", "--reverse", range.c_str(), "--", 0};
   const char* git_diff_tree[] =
@@ -627,6 +669,32 @@ void cmCTestGIT::LoadRevisions()
   cmsysProcess_Delete(cp);
 }
 
+//----------------------------------------------------------------------------
+void cmCTestGIT::LoadRevisionSummary(unsigned long count,
+                                     unsigned long limit)
+{
+  // Use 'git diff-tree old new' to get the net change of each file.
+  const char* git = this->CommandLineTool.c_str();
+  const char* git_diff_tree[] =
+    {git, "diff-tree", "-z", "-r", this->OldRevision.c_str(),
+     this->NewRevision.c_str(), "--", 0};
+  DiffParser out(this, "ds-out> ");
+  OutputLogger err(this->Log, "ds-err> ");
+  this->RunChild(git_diff_tree, &out, &err);
+
+  // Attribute all changes to the new revision.
+  cmOStringStream log;
+  log << "More than " << limit << " revisions from "
+      << this->OldRevision << " to " << this->NewRevision
+      << " (limit set by CTEST_GIT_UPDATE_REVISION_LIMIT).\n"
+      << "Per-revision logs were not collected.\n";
+  Revision rev;
+  rev.Rev = this->NewRevision;
+  rev.Log = log.str();
+  this->Log << "Summarizing at least " << count << " revisions\n";
+  this->DoRevision(rev, out.Changes);
+}
+
 //----------------------------------------------------------------------------
 void cmCTestGIT::LoadModifications()
 {
@@ -42,14 +42,17 @@ private:
   bool UpdateInternal();
 
   void LoadRevisions();
+  void LoadRevisionSummary(unsigned long count, unsigned long limit);
   void LoadModifications();
 
 public: // needed by older Sun compilers
   // Parsing helper classes.
   class OneLineParser;
+  class CountParser;
   class DiffParser;
   class CommitParser;
   friend class OneLineParser;
+  friend class CountParser;
   friend class DiffParser;
   friend class CommitParser;
 };
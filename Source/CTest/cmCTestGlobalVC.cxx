@@ -49,26 +49,30 @@ void cmCTestGlobalVC::DoRevision(Revision const& revision,
   // Indicate we found a revision.
   cmCTestLog(this->CTest, HANDLER_OUTPUT, "." << std::flush);
 
-  // Store the revision.
-  this->Revisions.push_back(revision);
-
   // Report this revision.
-  Revision const& rev = this->Revisions.back();
-  this->Log << "Found revision " << rev.Rev << "\n"
-            << "  author = " << rev.Author << "\n"
-            << "  date = " << rev.Date << "\n";
-
-  // Update information about revisions of the changed files.
+  this->Log << "Found revision " << revision.Rev << "\n"
+            << "  author = " << revision.Author << "\n"
+            << "  date = " << revision.Date << "\n";
+
+  // Update information about revisions of the changed files.  Store
+  // the revision only once a file refers to it so that long histories
+  // of merges or changes outside our tree do not accumulate.
+  Revision const* rev = 0;
   for(std::vector<Change>::const_iterator ci = changes.begin();
       ci != changes.end(); ++ci)
     {
     if(const char* local = this->LocalPath(ci->Path))
       {
+      if(!rev)
+        {
+        this->Revisions.push_back(revision);
+        rev = &this->Revisions.back();
+        }
       std::string dir = cmSystemTools::GetFilenamePath(local);
       std::string name = cmSystemTools::GetFilenameName(local);
       File& file = this->Dirs[dir][name];
       file.PriorRev = file.Rev? file.Rev : &this->PriorRev;
-      file.Rev = &rev;
+      file.Rev = rev;
       this->Log << "  " << ci->Action << " " << local << " " << "\n";
       }
     }
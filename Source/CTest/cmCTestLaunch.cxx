@@ -20,6 +20,13 @@
 #include <cmsys/Process.h>
 #include <cmsys/RegularExpression.hxx>
 
+#if !defined(_WIN32) || defined(__CYGWIN__)
+# include <errno.h>
+# include <fcntl.h>
+# include <unistd.h>
+# define CM_CTEST_LAUNCH_JOURNAL
+#endif
+
 //----------------------------------------------------------------------------
 cmCTestLaunch::cmCTestLaunch(int argc, const char* const* argv)
 {
@@ -36,8 +43,6 @@ cmCTestLaunch::cmCTestLaunch(int argc, const char* const* argv)
   this->ComputeFileNames();
 
   this->ScrapeRulesLoaded = false;
-  this->HaveOut = false;
-  this->HaveErr = false;
   this->Process = cmsysProcess_New();
 }
 
@@ -45,11 +50,6 @@ cmCTestLaunch::cmCTestLaunch(int argc, const char* const* argv)
 cmCTestLaunch::~cmCTestLaunch()
 {
   cmsysProcess_Delete(this->Process);
-  if(!this->Passthru)
-    {
-    cmSystemTools::RemoveFile(this->LogOut.c_str());
-    cmSystemTools::RemoveFile(this->LogErr.c_str());
-    }
 }
 
 //----------------------------------------------------------------------------
@@ -205,16 +205,6 @@ void cmCTestLaunch::ComputeFileNames()
   cmsysMD5_FinalizeHex(md5, hash);
   cmsysMD5_Delete(md5);
   this->LogHash.assign(hash, 32);
-
-  // We store stdout and stderr in temporary log files.
-  this->LogOut = this->LogDir;
-  this->LogOut += "launch-";
-  this->LogOut += this->LogHash;
-  this->LogOut += "-out.txt";
-  this->LogErr = this->LogDir;
-  this->LogErr += "launch-";
-  this->LogErr += this->LogHash;
-  this->LogErr += "-err.txt";
 }
 
 //----------------------------------------------------------------------------
@@ -231,27 +221,19 @@ void cmCTestLaunch::RunChild()
   cmsysProcess* cp = this->Process;
   cmsysProcess_SetCommand(cp, this->RealArgV);
 
-  std::ofstream fout;
-  std::ofstream ferr;
   if(this->Passthru)
     {
     // In passthru mode we just share the output pipes.
     cmsysProcess_SetPipeShared(cp, cmsysProcess_Pipe_STDOUT, 1);
     cmsysProcess_SetPipeShared(cp, cmsysProcess_Pipe_STDERR, 1);
     }
-  else
-    {
-    // In full mode we record the child output pipes to log files.
-    fout.open(this->LogOut.c_str(),
-              std::ios::out | std::ios::binary);
-    ferr.open(this->LogErr.c_str(),
-              std::ios::out | std::ios::binary);
-    }
 
   // Run the real command.
   cmsysProcess_Execute(cp);
 
-  // Record child stdout and stderr if necessary.
+  // Record child stdout and stderr in memory if necessary.  Most
+  // commands succeed quietly, so nothing touches the disk unless a
+  // fragment has to be reported.
   if(!this->Passthru)
     {
     char* data = 0;
@@ -260,15 +242,13 @@ void cmCTestLaunch::RunChild()
       {
       if(p == cmsysProcess_Pipe_STDOUT)
         {
-        fout.write(data, length);
+        this->OutputOut.append(data, length);
         std::cout.write(data, length);
-        this->HaveOut = true;
         }
       else if(p == cmsysProcess_Pipe_STDERR)
         {
-        ferr.write(data, length);
+        this->OutputErr.append(data, length);
         std::cerr.write(data, length);
-        this->HaveErr = true;
         }
       }
     }
@@ -375,14 +355,8 @@ bool cmCTestLaunch::IsError() const
 //----------------------------------------------------------------------------
 void cmCTestLaunch::WriteXML()
 {
-  // Name the xml file.
-  std::string logXML = this->LogDir;
-  logXML += this->IsError()? "error-" : "warning-";
-  logXML += this->LogHash;
-  logXML += ".xml";
-
-  // Use cmGeneratedFileStream to atomically create the report file.
-  cmGeneratedFileStream fxml(logXML.c_str());
+  // Generate the xml fragment.
+  cmOStringStream fxml;
   fxml << "\t<Failure type=\""
        << (this->IsError()? "Error" : "Warning") << "\">\n";
   this->WriteXMLAction(fxml);
@@ -390,6 +364,97 @@ void cmCTestLaunch::WriteXML()
   this->WriteXMLResult(fxml);
   this->WriteXMLLabels(fxml);
   fxml << "\t</Failure>\n";
+  std::string fragment = fxml.str();
+
+  // Append the fragment to the journal shared by all launchers.
+  if(this->AppendJournal(fragment))
+    {
+    return;
+    }
+
+  // Fall back to a file per fragment.
+  std::string logXML = this->LogDir;
+  logXML += this->IsError()? "error-" : "warning-";
+  logXML += this->LogHash;
+  logXML += ".xml";
+
+  // Use cmGeneratedFileStream to atomically create the report file.
+  cmGeneratedFileStream fout(logXML.c_str());
+  fout << fragment;
+}
+
+//----------------------------------------------------------------------------
+bool cmCTestLaunch::AppendJournal(std::string const& fragment)
+{
+#if defined(CM_CTEST_LAUNCH_JOURNAL)
+  // Each record is a fixed-size header followed by the fragment:
+  //   "CTLJ" <E|W> <32-char command hash> <8 hex digit length>
+  char len[9];
+  sprintf(len, "%08lx", static_cast<unsigned long>(fragment.size()));
+  std::string record = "CTLJ";
+  record += this->IsError()? "E" : "W";
+  record += this->LogHash;
+  record += len;
+  record += fragment;
+
+  std::string journal = this->LogDir + "fragments.journal";
+  int fd = open(journal.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0666);
+  if(fd < 0)
+    {
+    return false;
+    }
+
+  // Hold an exclusive lock so concurrent launchers never interleave
+  // records, even where O_APPEND alone is not atomic.
+  struct flock lock;
+  memset(&lock, 0, sizeof(lock));
+  lock.l_type = F_WRLCK;
+  lock.l_whence = SEEK_SET;
+  int r;
+  while((r = fcntl(fd, F_SETLKW, &lock)) < 0 && errno == EINTR) {}
+  if(r < 0)
+    {
+    close(fd);
+    return false;
+    }
+
+  // Records are appended at the end, where this one starts.
+  off_t start = lseek(fd, 0, SEEK_END);
+  if(start < 0)
+    {
+    close(fd);
+    return false;
+    }
+
+  const char* data = record.data();
+  size_t left = record.size();
+  while(left > 0)
+    {
+    ssize_t n = write(fd, data, left);
+    if(n < 0 && errno == EINTR)
+      {
+      continue;
+      }
+    if(n <= 0)
+      {
+      break;
+      }
+    data += n;
+    left -= static_cast<size_t>(n);
+    }
+
+  // Remove the part of a record left by a short write while still
+  // holding the lock so that the next record follows a complete one.
+  if(left > 0)
+    {
+    while(ftruncate(fd, start) < 0 && errno == EINTR) {}
+    }
+  close(fd);
+  return left == 0;
+#else
+  static_cast<void>(fragment);
+  return false;
+#endif
 }
 
 //----------------------------------------------------------------------------
@@ -509,12 +574,12 @@ void cmCTestLaunch::WriteXMLResult(std::ostream& fxml)
 
   // StdOut
   fxml << "\t\t\t<StdOut>";
-  this->DumpFileToXML(fxml, this->LogOut);
+  this->DumpOutputToXML(fxml, this->OutputOut);
   fxml << "</StdOut>\n";
 
   // StdErr
   fxml << "\t\t\t<StdErr>";
-  this->DumpFileToXML(fxml, this->LogErr);
+  this->DumpOutputToXML(fxml, this->OutputErr);
   fxml << "</StdErr>\n";
 
   // ExitCondition
@@ -566,20 +631,44 @@ void cmCTestLaunch::WriteXMLLabels(std::ostream& fxml)
 }
 
 //----------------------------------------------------------------------------
-void cmCTestLaunch::DumpFileToXML(std::ostream& fxml,
-                                  std::string const& fname)
+void cmCTestLaunch::DumpOutputToXML(std::ostream& fxml,
+                                    std::string const& output)
 {
-  std::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
-
   std::string line;
   const char* sep = "";
-  while(cmSystemTools::GetLineFromStream(fin, line))
+  std::string::size_type pos = 0;
+  while(GetOutputLine(output, pos, line))
     {
     fxml << sep << cmXMLSafe(line).Quotes(false);
     sep = "\n";
     }
 }
 
+//----------------------------------------------------------------------------
+bool cmCTestLaunch::GetOutputLine(std::string const& output,
+                                  std::string::size_type& pos,
+                                  std::string& line)
+{
+  // Split lines like cmSystemTools::GetLineFromStream does.
+  if(pos >= output.size())
+    {
+    return false;
+    }
+  std::string::size_type end = output.find('\n', pos);
+  std::string::size_type next = end + 1;
+  if(end == std::string::npos)
+    {
+    end = next = output.size();
+    }
+  if(end > pos && output[end-1] == '\r')
+    {
+    --end;
+    }
+  line.assign(output, pos, end - pos);
+  pos = next;
+  return true;
+}
+
 //----------------------------------------------------------------------------
 bool cmCTestLaunch::CheckResults()
 {
@@ -596,8 +685,8 @@ bool cmCTestLaunch::CheckResults()
     }
 
   // Scrape the output logs to look for warnings.
-  if((this->HaveErr && this->ScrapeLog(this->LogErr)) ||
-     (this->HaveOut && this->ScrapeLog(this->LogOut)))
+  if((!this->OutputErr.empty() && this->ScrapeLog(this->OutputErr)) ||
+     (!this->OutputOut.empty() && this->ScrapeLog(this->OutputOut)))
     {
     return false;
     }
@@ -648,15 +737,15 @@ cmCTestLaunch
 }
 
 //----------------------------------------------------------------------------
-bool cmCTestLaunch::ScrapeLog(std::string const& fname)
+bool cmCTestLaunch::ScrapeLog(std::string const& output)
 {
   this->LoadScrapeRules();
 
-  // Look for log file lines matching warning expressions but not
+  // Look for output lines matching warning expressions but not
   // suppression expressions.
-  std::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
   std::string line;
-  while(cmSystemTools::GetLineFromStream(fin, line))
+  std::string::size_type pos = 0;
+  while(GetOutputLine(output, pos, line))
     {
     if(this->Match(line.c_str(), this->RegexWarning) &&
        !this->Match(line.c_str(), this->RegexWarningSuppress))
@@ -64,12 +64,13 @@ private:
   struct cmsysProcess_s* Process;
   int ExitCode;
 
-  // Temporary log files for stdout and stderr of real command.
+  // Directory for build logs, and stdout and stderr of real command.
   std::string LogDir;
-  std::string LogOut;
-  std::string LogErr;
-  bool HaveOut;
-  bool HaveErr;
+  std::string OutputOut;
+  std::string OutputErr;
+  static bool GetOutputLine(std::string const& output,
+                            std::string::size_type& pos,
+                            std::string& line);
 
   // Labels associated with the build rule.
   std::set<cmStdString> Labels;
@@ -84,17 +85,18 @@ private:
   void LoadScrapeRules();
   void LoadScrapeRules(const char* purpose,
                        std::vector<cmsys::RegularExpression>& regexps);
-  bool ScrapeLog(std::string const& fname);
+  bool ScrapeLog(std::string const& output);
   bool Match(std::string const& line,
              std::vector<cmsys::RegularExpression>& regexps);
 
   // Methods to generate the xml fragment.
   void WriteXML();
+  bool AppendJournal(std::string const& fragment);
   void WriteXMLAction(std::ostream& fxml);
   void WriteXMLCommand(std::ostream& fxml);
   void WriteXMLResult(std::ostream& fxml);
   void WriteXMLLabels(std::ostream& fxml);
-  void DumpFileToXML(std::ostream& fxml, std::string const& fname);
+  void DumpOutputToXML(std::ostream& fxml, std::string const& output);
 
   // Configuration
   void LoadConfig();
@@ -209,7 +209,7 @@ void cmCTestMemCheckHandler::Initialize()
     {
     this->MemoryTesterGlobalResults[cc] = 0;
     }
-
+  this->ValgrindStacks.clear();
 }
 
 //----------------------------------------------------------------------
@@ -324,7 +324,7 @@ void cmCTestMemCheckHandler::GenerateDartOutput(std::ostream& os)
     int memcheckresults[cmCTestMemCheckHandler::NO_MEMORY_FAULT];
     int kk;
     bool res = this->ProcessMemCheckOutput(result->Output, memcheckstr,
-      memcheckresults);
+      memcheckresults, result->Name);
     if ( res && result->Status == cmCTestMemCheckHandler::COMPLETED )
       {
       continue;
@@ -558,7 +558,8 @@ bool cmCTestMemCheckHandler::InitializeMemoryChecking()
 
 //----------------------------------------------------------------------
 bool cmCTestMemCheckHandler::ProcessMemCheckOutput(const std::string& str,
-                                               std::string& log, int* results)
+                                               std::string& log, int* results,
+                                               const std::string& testName)
 {
   std::string::size_type cc;
   for ( cc = 0; cc < cmCTestMemCheckHandler::NO_MEMORY_FAULT; cc ++ )
@@ -568,7 +569,7 @@ bool cmCTestMemCheckHandler::ProcessMemCheckOutput(const std::string& str,
 
   if ( this->MemoryTesterStyle == cmCTestMemCheckHandler::VALGRIND )
     {
-    return this->ProcessMemCheckValgrindOutput(str, log, results);
+    return this->ProcessMemCheckValgrindOutput(str, log, results, testName);
     }
   else if ( this->MemoryTesterStyle == cmCTestMemCheckHandler::PURIFY )
     {
@@ -644,10 +645,62 @@ bool cmCTestMemCheckHandler::ProcessMemCheckPurifyOutput(
   return true;
 }
 
+//----------------------------------------------------------------------
+static void cmCTestMemCheckAppendStackKey(std::string& key, const char* c)
+{
+  // Addresses differ between executables and runs; drop them.
+  while(*c)
+    {
+    if(c[0] == '0' && c[1] == 'x')
+      {
+      for(c += 2; isxdigit(*c); ++c) {}
+      }
+    else
+      {
+      key += *c++;
+      }
+    }
+  key += "\n";
+}
+
+//----------------------------------------------------------------------
+void cmCTestMemCheckHandler::WriteValgrindBlock(std::ostream& os,
+  std::vector<std::string> const& block, std::string const& key,
+  const std::string& testName)
+{
+  if(block.empty())
+    {
+    return;
+    }
+
+  // Report a stack in full only for the first test that hits it.
+  if(block.size() > 1)
+    {
+    std::map<cmStdString, cmStdString>::iterator si =
+      this->ValgrindStacks.find(key);
+    if(si == this->ValgrindStacks.end())
+      {
+      this->ValgrindStacks[key] = testName;
+      }
+    else if(si->second != testName)
+      {
+      os << block[0] << std::endl
+         << cmXMLSafe("    (same stack as reported for test "
+                      + si->second + ")") << std::endl;
+      return;
+      }
+    }
+  for(std::vector<std::string>::const_iterator bi = block.begin();
+      bi != block.end(); ++bi)
+    {
+    os << *bi << std::endl;
+    }
+}
+
 //----------------------------------------------------------------------
 bool cmCTestMemCheckHandler::ProcessMemCheckValgrindOutput(
   const std::string& str, std::string& log,
-  int* results)
+  int* results, const std::string& testName)
 {
   std::vector<cmStdString> lines;
   cmSystemTools::Split(str.c_str(), lines);
@@ -698,6 +751,37 @@ bool cmCTestMemCheckHandler::ProcessMemCheckValgrindOutput(
   cmsys::RegularExpression vgIPW("== .*Invalid write of size [0-9,]+");
   cmsys::RegularExpression vgABR("== .*pthread_mutex_unlock: mutex is "
     "locked by a different thread");
+
+  // Try each expression only on lines containing its literal text.
+  // Most valgrind lines are stack frames that match none of them.
+  struct
+  {
+    const char* Literal;
+    cmsys::RegularExpression* Regex;
+    int Failure;
+  } vgRules[] = {
+    {"Invalid free()", &vgFIM, cmCTestMemCheckHandler::FIM},
+    {"Mismatched free()", &vgFMM, cmCTestMemCheckHandler::FMM},
+    {"definitely lost", &vgMLK1, cmCTestMemCheckHandler::MLK},
+    {"definitely lost", &vgMLK2, cmCTestMemCheckHandler::MLK},
+    {"Syscall param", &vgPAR, cmCTestMemCheckHandler::PAR},
+    {"possibly lost", &vgMPK1, cmCTestMemCheckHandler::MPK},
+    {"still reachable", &vgMPK2, cmCTestMemCheckHandler::MPK},
+    {"Conditional jump", &vgUMC, cmCTestMemCheckHandler::UMC},
+    {"Use of uninitialised value", &vgUMR1, cmCTestMemCheckHandler::UMR},
+    {"Invalid read of size", &vgUMR2, cmCTestMemCheckHandler::UMR},
+    {"Jump to the invalid address", &vgUMR3, cmCTestMemCheckHandler::UMR},
+    {"Syscall param", &vgUMR4, cmCTestMemCheckHandler::UMR},
+    {"Syscall param", &vgUMR5, cmCTestMemCheckHandler::UMR},
+    {"Invalid write of size", &vgIPW, cmCTestMemCheckHandler::IPW},
+    {"pthread_mutex_unlock", &vgABR, cmCTestMemCheckHandler::ABR},
+    {0, 0, 0}
+  };
+
+  // Lines describing one error are grouped so that a stack already
+  // reported for another test is not repeated in full.
+  std::vector<std::string> block;
+  std::string blockKey;
   std::vector<std::string::size_type> nonValGrindOutput;
   double sttime = cmSystemTools::GetTime();
   cmCTestLog(this->CTest, DEBUG, "Start test: " << lines.size() << std::endl);
@@ -713,81 +797,54 @@ bool cmCTestMemCheckHandler::ProcessMemCheckValgrindOutput(
       cmCTestLog(this->CTest, DEBUG, "valgrind  line "
                  << lines[cc] << std::endl);
       int failure = cmCTestMemCheckHandler::NO_MEMORY_FAULT;
-      if ( vgFIM.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::FIM;
-        }
-      else if ( vgFMM.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::FMM;
-        }
-      else if ( vgMLK1.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::MLK;
-        }
-      else if ( vgMLK2.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::MLK;
-        }
-      else if ( vgPAR.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::PAR;
-        }
-      else if ( vgMPK1.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::MPK;
-        }
-      else if ( vgMPK2.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::MPK;
-        }
-      else if ( vgUMC.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::UMC;
-        }
-      else if ( vgUMR1.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::UMR;
-        }
-      else if ( vgUMR2.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::UMR;
-        }
-      else if ( vgUMR3.find(lines[cc]) )
+      const char* line = lines[cc].c_str();
+      for(int rr = 0; vgRules[rr].Literal; ++rr)
         {
-        failure = cmCTestMemCheckHandler::UMR;
-        }
-      else if ( vgUMR4.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::UMR;
-        }
-      else if ( vgUMR5.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::UMR;
-        }
-      else if ( vgIPW.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::IPW;
-        }
-      else if ( vgABR.find(lines[cc]) )
-        {
-        failure = cmCTestMemCheckHandler::ABR;
+        if(strstr(line, vgRules[rr].Literal) &&
+           vgRules[rr].Regex->find(line))
+          {
+          failure = vgRules[rr].Failure;
+          break;
+          }
         }
 
+      totalOutputSize += lines[cc].size();
+      const char* msg = line + valgrindLine.end();
       if ( failure != cmCTestMemCheckHandler::NO_MEMORY_FAULT )
         {
-        ostr << "<b>" << cmCTestMemCheckResultStrings[failure] << "</b> ";
+        // A new error starts a new block.
+        this->WriteValgrindBlock(ostr, block, blockKey, testName);
+        block.clear();
+        blockKey = cmCTestMemCheckResultStrings[failure];
+        blockKey += "\n";
+        cmOStringStream header;
+        header << "<b>" << cmCTestMemCheckResultStrings[failure] << "</b> "
+               << cmXMLSafe(lines[cc]);
+        block.push_back(header.str());
         results[failure] ++;
         defects ++;
         }
-      totalOutputSize += lines[cc].size();
-      ostr << cmXMLSafe(lines[cc]) << std::endl;
+      else if ( !block.empty() && msg[0] == ' ' && msg[1] == ' ' )
+        {
+        // Indented lines continue the current error.
+        cmCTestMemCheckAppendStackKey(blockKey, msg);
+        cmOStringStream entry;
+        entry << cmXMLSafe(lines[cc]);
+        block.push_back(entry.str());
+        }
+      else
+        {
+        this->WriteValgrindBlock(ostr, block, blockKey, testName);
+        block.clear();
+        ostr << cmXMLSafe(lines[cc]) << std::endl;
+        }
       } 
     else
       {
       nonValGrindOutput.push_back(cc);
       }
     }
+  this->WriteValgrindBlock(ostr, block, blockKey, testName);
   // Now put all all the non valgrind output into the test output
   if(!outputFull)
     {
@@ -94,6 +94,9 @@ private:
   std::string              MemoryTesterOutputFile;
   int                      MemoryTesterGlobalResults[NO_MEMORY_FAULT];
 
+  // Valgrind error stacks already reported, and the test reporting them.
+  std::map<cmStdString, cmStdString> ValgrindStacks;
+
   ///! Initialize memory checking subsystem.
   bool InitializeMemoryChecking();
 
@@ -108,10 +111,16 @@ private:
   //! Parse Valgrind/Purify/Bounds Checker result out of the output
   //string. After running, log holds the output and results hold the
   //different memmory errors.
-  bool ProcessMemCheckOutput(const std::string& str, 
-                             std::string& log, int* results);
-  bool ProcessMemCheckValgrindOutput(const std::string& str, 
-                                     std::string& log, int* results);
+  bool ProcessMemCheckOutput(const std::string& str,
+                             std::string& log, int* results,
+                             const std::string& testName);
+  bool ProcessMemCheckValgrindOutput(const std::string& str,
+                                     std::string& log, int* results,
+                                     const std::string& testName);
+  void WriteValgrindBlock(std::ostream& os,
+                          std::vector<std::string> const& block,
+                          std::string const& key,
+                          const std::string& testName);
   bool ProcessMemCheckPurifyOutput(const std::string& str, 
                                    std::string& log, int* results);
   bool ProcessMemCheckBoundsCheckerOutput(const std::string& str, 
@@ -353,24 +353,21 @@ void cmCTestMultiProcessHandler::UpdateCostData()
       if(line == "---") break;
       std::vector<cmsys::String> parts = 
         cmSystemTools::SplitString(line.c_str(), ' ');
-      //Format: <name> <previous_runs> <avg_cost>
+      //Format: <name> <previous_runs> <avg_cost> [<avg_cpu> <max_rss>]
       if(parts.size() < 3) break;
 
       std::string name = parts[0];
-      int prev = atoi(parts[1].c_str());
-      float cost = static_cast<float>(atof(parts[2].c_str()));
 
       int index = this->SearchByName(name);
       if(index == -1)
         {
         // This test is not in memory. We just rewrite the entry
-        fout << name << " " << prev << " " << cost << "\n";
+        fout << line << "\n";
         }
       else
         {
         // Update with our new average cost
-        fout << name << " " << this->Properties[index]->PreviousRuns << " "
-          << this->Properties[index]->Cost << "\n";
+        this->WriteCostEntry(fout, this->Properties[index]);
         temp.erase(index);
         }
       }
@@ -381,8 +378,7 @@ void cmCTestMultiProcessHandler::UpdateCostData()
   // Add all tests not previously listed in the file
   for(PropertiesMap::iterator i = temp.begin(); i != temp.end(); ++i)
     {
-    fout << i->second->Name << " " << i->second->PreviousRuns << " "
-      << i->second->Cost << "\n";
+    this->WriteCostEntry(fout, i->second);
     }
 
   // Write list of failed tests
@@ -396,6 +392,18 @@ void cmCTestMultiProcessHandler::UpdateCostData()
   cmSystemTools::RenameFile(tmpout.c_str(), fname.c_str());
 }
 
+//---------------------------------------------------------
+void cmCTestMultiProcessHandler::WriteCostEntry(std::ostream& fout,
+  cmCTestTestHandler::cmCTestTestProperties* p)
+{
+  fout << p->Name << " " << p->PreviousRuns << " " << p->Cost;
+  if(p->MaxResidentSize > 0)
+    {
+    fout << " " << p->CPUCost << " " << p->MaxResidentSize;
+    }
+  fout << "\n";
+}
+
 //---------------------------------------------------------
 void cmCTestMultiProcessHandler::ReadCostData()
 {
@@ -428,6 +436,14 @@ void cmCTestMultiProcessHandler::ReadCostData()
       if(index == -1) continue;
 
       this->Properties[index]->PreviousRuns = prev;
+      // Resource usage columns are absent in files written by older
+      // versions
+      if(parts.size() >= 5)
+        {
+        this->Properties[index]->CPUCost =
+          static_cast<float>(atof(parts[3].c_str()));
+        this->Properties[index]->MaxResidentSize = atol(parts[4].c_str());
+        }
       // When not running in parallel mode, don't use cost data
       if(this->ParallelLevel > 1 &&
          this->Properties[index] &&
@@ -68,6 +68,9 @@ protected:
 
   void UpdateCostData();
   void ReadCostData();
+  // Write one line of the cost data file for the given test
+  void WriteCostEntry(std::ostream& fout,
+                      cmCTestTestHandler::cmCTestTestProperties* p);
   // Return index of a test based on its name
   int SearchByName(std::string name);
 
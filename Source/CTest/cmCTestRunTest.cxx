@@ -29,6 +29,7 @@ cmCTestRunTest::cmCTestRunTest(cmCTestTestHandler* handler)
   this->TestResult.Status = cmCTestTestHandler::NOT_RUN;
   this->TestResult.TestCount = 0;
   this->TestResult.Properties = 0;
+  this->TestResult.HasResourceUsage = false;
   this->ProcessOutput = "";
   this->CompressedOutput = "";
   this->CompressionRatio = 2;
@@ -260,14 +261,29 @@ bool cmCTestRunTest::EndTest(size_t completed, size_t total, bool started)
   sprintf(buf, "%6.2f sec", this->TestProcess->GetTotalTime());
   cmCTestLog(this->CTest, HANDLER_OUTPUT, buf << "\n" );
 
+  std::string usage;
+  if ( started && this->TestProcess->HasResourceUsage() )
+    {
+    this->RecordResourceUsage();
+    usage = this->GetResourceUsageSummary();
+    }
+
   if ( outputTestErrorsToConsole )
     {
     cmCTestLog(this->CTest, HANDLER_OUTPUT, this->ProcessOutput << std::endl );
+    if ( !usage.empty() )
+      {
+      cmCTestLog(this->CTest, HANDLER_OUTPUT, usage << std::endl);
+      }
     }
 
   if ( this->TestHandler->LogFile )
     {
     *this->TestHandler->LogFile << "Test time = " << buf << std::endl;
+    if ( !usage.empty() )
+      {
+      *this->TestHandler->LogFile << usage << std::endl;
+      }
     }
 
   // Set the working directory to the tests directory
@@ -367,10 +383,54 @@ void cmCTestRunTest::ComputeWeightedCost()
     {
     this->TestProperties->Cost =
       static_cast<float>(((prev * avgcost) + current) / (prev + 1.0));
+    if(this->TestResult.HasResourceUsage)
+      {
+      double cpu = this->TestResult.UserTime + this->TestResult.SystemTime;
+      this->TestProperties->CPUCost = static_cast<float>(
+        ((prev * this->TestProperties->CPUCost) + cpu) / (prev + 1.0));
+      if(this->TestResult.MaxResidentSize >
+         this->TestProperties->MaxResidentSize)
+        {
+        this->TestProperties->MaxResidentSize =
+          this->TestResult.MaxResidentSize;
+        }
+      }
     this->TestProperties->PreviousRuns++;
     }
 }
 
+//----------------------------------------------------------------------
+void cmCTestRunTest::RecordResourceUsage()
+{
+  cmsysProcess_ResourceUsage const& usage =
+    this->TestProcess->GetResourceUsage();
+  this->TestResult.HasResourceUsage = true;
+  this->TestResult.UserTime = usage.UserTime;
+  this->TestResult.SystemTime = usage.SystemTime;
+  this->TestResult.MaxResidentSize = usage.MaxResidentSize;
+  this->TestResult.VoluntaryContextSwitches = usage.VoluntaryContextSwitches;
+  this->TestResult.InvoluntaryContextSwitches =
+    usage.InvoluntaryContextSwitches;
+  this->TestResult.BlockInputOperations = usage.BlockInputOperations;
+  this->TestResult.BlockOutputOperations = usage.BlockOutputOperations;
+}
+
+//----------------------------------------------------------------------
+std::string cmCTestRunTest::GetResourceUsageSummary()
+{
+  char buf[1024];
+  sprintf(buf, "Test resources = %.2f sec user, %.2f sec system, "
+          "%ld KB max resident, %ld/%ld voluntary/involuntary "
+          "context switches, %ld/%ld block input/output operations",
+          this->TestResult.UserTime, this->TestResult.SystemTime,
+          this->TestResult.MaxResidentSize,
+          this->TestResult.VoluntaryContextSwitches,
+          this->TestResult.InvoluntaryContextSwitches,
+          this->TestResult.BlockInputOperations,
+          this->TestResult.BlockOutputOperations);
+  return buf;
+}
+
 //----------------------------------------------------------------------
 void cmCTestRunTest::MemCheckPostProcess()
 {
@@ -407,6 +467,7 @@ bool cmCTestRunTest::StartTest(size_t total)
   std::vector<std::string>& args = this->TestProperties->Args;
   this->TestResult.Properties = this->TestProperties;
   this->TestResult.ExecutionTime = 0;
+  this->TestResult.HasResourceUsage = false;
   this->TestResult.CompressOutput = false;
   this->TestResult.ReturnValue = -1;
   this->TestResult.CompletionStatus = "Failed to start";
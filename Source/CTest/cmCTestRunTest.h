@@ -68,6 +68,9 @@ private:
   void WriteLogOutputTop(size_t completed, size_t total);
   //Run post processing of the process output for MemCheck
   void MemCheckPostProcess();
+  //Copy the resources used by the test process into the result
+  void RecordResourceUsage();
+  std::string GetResourceUsageSummary();
 
   cmCTestTestHandler::cmCTestTestProperties * TestProperties;
   //Pointer back to the "parent"; the handler that invoked this test run
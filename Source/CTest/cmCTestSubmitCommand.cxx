@@ -60,6 +60,8 @@ cmCTestGenericHandler* cmCTestSubmitCommand::InitializeHandler()
 
   this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
     "CurlOptions", "CTEST_CURL_OPTIONS");
+  this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
+    "CompressSubmission", "CTEST_COMPRESS_SUBMISSION");
   this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
     "DropSiteUser", "CTEST_DROP_SITE_USER");
   this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
@@ -25,6 +25,7 @@
 
 // For curl submission
 #include "cm_curl.h"
+#include <cm_zlib.h>
 
 #include <sys/stat.h>
 
@@ -322,6 +323,67 @@ bool cmCTestSubmitHandler::SubmitUsingFTP(const cmStdString& localprefix,
   return true;
 }
 
+//----------------------------------------------------------------------------
+// Compress a file with gzip while curl reads it for upload.
+class cmCTestSubmitHandlerGzipReader
+{
+public:
+  cmCTestSubmitHandlerGzipReader(): File(0), Finished(false)
+    {
+    memset(&this->Stream, 0, sizeof(this->Stream));
+    deflateInit2(&this->Stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                 15+16, 8, Z_DEFAULT_STRATEGY);
+    }
+  ~cmCTestSubmitHandlerGzipReader() { deflateEnd(&this->Stream); }
+
+  void Reset(FILE* file)
+    {
+    deflateReset(&this->Stream);
+    this->Stream.avail_in = 0;
+    this->File = file;
+    this->Finished = false;
+    }
+
+  static size_t Read(void* ptr, size_t size, size_t nmemb, void* data)
+    {
+    cmCTestSubmitHandlerGzipReader* self =
+      static_cast<cmCTestSubmitHandlerGzipReader*>(data);
+    z_stream& strm = self->Stream;
+    strm.next_out = static_cast<Bytef*>(ptr);
+    strm.avail_out = static_cast<uInt>(size*nmemb);
+    while(strm.avail_out > 0 && !self->Finished)
+      {
+      if(strm.avail_in == 0 && !feof(self->File))
+        {
+        strm.next_in = self->Buffer;
+        strm.avail_in = static_cast<uInt>(
+          fread(self->Buffer, 1, sizeof(self->Buffer), self->File));
+        if(ferror(self->File))
+          {
+          return CURL_READFUNC_ABORT;
+          }
+        }
+      int flush = feof(self->File)? Z_FINISH : Z_NO_FLUSH;
+      int r = deflate(&strm, flush);
+      if(r == Z_STREAM_END)
+        {
+        self->Finished = true;
+        }
+      else if(r != Z_OK && r != Z_BUF_ERROR)
+        {
+        return CURL_READFUNC_ABORT;
+        }
+      }
+    return size*nmemb - strm.avail_out;
+    }
+
+private:
+  FILE* File;
+  z_stream Stream;
+  Bytef Buffer[16384];
+  bool Finished;
+};
+
 //----------------------------------------------------------------------------
 // Uploading files is simpler
 bool cmCTestSubmitHandler::SubmitUsingHTTP(const cmStdString& localprefix,
@@ -354,12 +416,42 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const cmStdString& localprefix,
       verifyHostOff = true;
       }
     }
+
+  // Optionally compress files on the fly.  The size is not known in
+  // advance, so this needs chunked transfers that HTTP 1.0 lacks.
+  bool compress = !this->CTest->ShouldUseHTTP10() &&
+    cmSystemTools::IsOn(
+      this->CTest->GetCTestConfiguration("CompressSubmission").c_str());
+  struct curl_slist* headers = 0;
+  if(compress)
+    {
+    headers = ::curl_slist_append(headers, "Content-Encoding: gzip");
+    headers = ::curl_slist_append(headers, "Transfer-Encoding: chunked");
+    }
+
+  // Files accepted by this url are listed in a journal so that a
+  // partially failed submission resumes where it stopped.  The journal
+  // is removed once a submission succeeds, so a later submission of
+  // the same files sends them again.
+  bool useJournal = !cmSystemTools::IsOn(this->GetOption("InternalTest"));
+  std::string journalFile = localprefix + "/SubmitJournal.txt";
+  std::set<cmStdString> submitted;
+  if(useJournal)
+    {
+    std::ifstream fin(journalFile.c_str());
+    std::string line;
+    while(cmSystemTools::GetLineFromStream(fin, line))
+      {
+      submitted.insert(line);
+      }
+    }
+
+  /* get a curl handle, reused for every file to keep the connection */
+  curl = curl_easy_init();
   cmStdString::size_type kk;
   cmCTest::SetOfStrings::const_iterator file;
   for ( file = files.begin(); file != files.end(); ++file )
     {
-    /* get a curl handle */
-    curl = curl_easy_init();
     if(curl)
       {
       if(verifyPeerOff)
@@ -466,12 +558,20 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const cmStdString& localprefix,
         upload_as += md5;
         }
 
+      if(submitted.find(upload_as) != submitted.end())
+        {
+        cmCTestLog(this->CTest, HANDLER_OUTPUT, "   Already uploaded: "
+          + local_file << std::endl);
+        continue;
+        }
+
       struct stat st;
       if ( ::stat(local_file.c_str(), &st) )
         {
         cmCTestLog(this->CTest, ERROR_MESSAGE, "   Cannot find file: "
           << local_file.c_str() << std::endl);
         ::curl_easy_cleanup(curl);
+        ::curl_slist_free_all(headers);
         ::curl_global_cleanup();
         return false;
         }
@@ -485,11 +585,24 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const cmStdString& localprefix,
       ::curl_easy_setopt(curl,CURLOPT_URL, upload_as.c_str());
 
       // now specify which file to upload
-      ::curl_easy_setopt(curl, CURLOPT_INFILE, ftpfile);
+      cmCTestSubmitHandlerGzipReader gzipReader;
+      if(compress)
+        {
+        gzipReader.Reset(ftpfile);
+        ::curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        ::curl_easy_setopt(curl, CURLOPT_READFUNCTION,
+                           &cmCTestSubmitHandlerGzipReader::Read);
+        ::curl_easy_setopt(curl, CURLOPT_INFILE, &gzipReader);
+        ::curl_easy_setopt(curl, CURLOPT_INFILESIZE, -1L);
+        }
+      else
+        {
+        ::curl_easy_setopt(curl, CURLOPT_INFILE, ftpfile);
 
-      // and give the size of the upload (optional)
-      ::curl_easy_setopt(curl, CURLOPT_INFILESIZE,
-        static_cast<long>(st.st_size));
+        // and give the size of the upload (optional)
+        ::curl_easy_setopt(curl, CURLOPT_INFILESIZE,
+          static_cast<long>(st.st_size));
+        }
 
       // and give curl the buffer for errors
       ::curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, &error_buffer);
@@ -567,7 +680,14 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const cmStdString& localprefix,
 
           ::fclose(ftpfile);
           ftpfile = ::fopen(local_file.c_str(), "rb");
-          ::curl_easy_setopt(curl, CURLOPT_INFILE, ftpfile);
+          if(compress)
+            {
+            gzipReader.Reset(ftpfile);
+            }
+          else
+            {
+            ::curl_easy_setopt(curl, CURLOPT_INFILE, ftpfile);
+            }
 
           chunk.clear();
           chunkDebug.clear();
@@ -614,15 +734,34 @@ bool cmCTestSubmitHandler::SubmitUsingHTTP(const cmStdString& localprefix,
                      << std::endl);
           }
         ::curl_easy_cleanup(curl);
+        ::curl_slist_free_all(headers);
         ::curl_global_cleanup();
         return false;
         }
-      // always cleanup
-      ::curl_easy_cleanup(curl);
       cmCTestLog(this->CTest, HANDLER_OUTPUT, "   Uploaded: " + local_file
         << std::endl);
+
+      // Record the upload so a resubmission can skip it.
+      if(useJournal && !this->HasErrors)
+        {
+        std::ofstream fout(journalFile.c_str(), std::ios::app);
+        fout << upload_as << "\n";
+        }
       }
     }
+  // A complete submission leaves nothing to resume.
+  if(curl && useJournal && !this->HasErrors)
+    {
+    cmSystemTools::RemoveFile(journalFile.c_str());
+    }
+  // always cleanup
+  if(curl)
+    {
+    // The debug output buffers belonged to the last file uploaded.
+    ::curl_easy_setopt(curl, CURLOPT_VERBOSE, 0);
+    ::curl_easy_cleanup(curl);
+    }
+  ::curl_slist_free_all(headers);
   ::curl_global_cleanup();
   return true;
 }
@@ -26,6 +26,9 @@ cmCTestTestCommand::cmCTestTestCommand()
   this->Arguments[ctt_PARALLEL_LEVEL] = "PARALLEL_LEVEL";
   this->Arguments[ctt_SCHEDULE_RANDOM] = "SCHEDULE_RANDOM";
   this->Arguments[ctt_STOP_TIME] = "STOP_TIME";
+  this->Arguments[ctt_SHARD] = "SHARD";
+  this->Arguments[ctt_FAIL_ON_PERFORMANCE_REGRESSION] =
+    "FAIL_ON_PERFORMANCE_REGRESSION";
   this->Arguments[ctt_LAST] = 0;
   this->Last = ctt_LAST;
 }
@@ -103,6 +106,15 @@ cmCTestGenericHandler* cmCTestTestCommand::InitializeHandler()
     {
     this->CTest->SetStopTime(this->Values[ctt_STOP_TIME]);
     }
+  if(this->Values[ctt_SHARD])
+    {
+    handler->SetOption("ShardInformation", this->Values[ctt_SHARD]);
+    }
+  if(this->Values[ctt_FAIL_ON_PERFORMANCE_REGRESSION])
+    {
+    handler->SetOption("FailOnPerformanceRegression",
+                       this->Values[ctt_FAIL_ON_PERFORMANCE_REGRESSION]);
+    }
   return handler;
 }
 
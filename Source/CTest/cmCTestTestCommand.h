@@ -63,7 +63,9 @@ public:
       "             [INCLUDE_LABEL label regex] \n"
       "             [PARALLEL_LEVEL level] \n"
       "             [SCHEDULE_RANDOM on] \n"
-      "             [STOP_TIME time of day]) \n"
+      "             [STOP_TIME time of day] \n"
+      "             [SHARD index/count] \n"
+      "             [FAIL_ON_PERFORMANCE_REGRESSION on]) \n"
       "Tests the given build directory and stores results in Test.xml. The "
       "second argument is a variable that will hold value. Optionally, "
       "you can specify the starting test number START, the ending test number "
@@ -75,7 +77,12 @@ public:
       "representing the number of tests to be run in parallel. "
       "SCHEDULE_RANDOM will launch tests in a random order, and is "
       "typically used to detect implicit test dependencies. STOP_TIME is the "
-      "time of day at which the tests should all stop running."
+      "time of day at which the tests should all stop running. SHARD runs "
+      "only shard number index of the tests split into count shards of "
+      "about equal cost, as for the ctest --shard option. "
+      "FAIL_ON_PERFORMANCE_REGRESSION makes the tests fail when one of them "
+      "became slower than in earlier runs, as for the ctest "
+      "--fail-on-performance-regression option."
       "\n"
       CTEST_COMMAND_APPEND_OPTION_DOCS;
     }
@@ -99,6 +106,8 @@ protected:
     ctt_PARALLEL_LEVEL,
     ctt_SCHEDULE_RANDOM,
     ctt_STOP_TIME,
+    ctt_SHARD,
+    ctt_FAIL_ON_PERFORMANCE_REGRESSION,
     ctt_LAST
   };
 };
@@ -100,6 +100,7 @@ bool cmCTestSubdirCommand
     if ( !cmSystemTools::FileIsDirectory(fname.c_str()) )
       {
       // No subdirectory? So what...
+      this->TestHandler->AddMissingTestfileDirectory(fname.c_str());
       continue;
       }
     cmSystemTools::ChangeDirectory(fname.c_str());
@@ -117,6 +118,7 @@ bool cmCTestSubdirCommand
     else
       {
       // No CTestTestfile? Who cares...
+      this->TestHandler->AddMissingTestfileDirectory(fname.c_str());
       cmSystemTools::ChangeDirectory(cwd.c_str());
       continue;
       }
@@ -191,6 +193,7 @@ bool cmCTestAddSubdirectoryCommand
   if ( !cmSystemTools::FileExists(fname.c_str()) )
     {
     // No subdirectory? So what...
+    this->TestHandler->AddMissingTestfileDirectory(fname.c_str());
     return true;
     }
   cmSystemTools::ChangeDirectory(fname.c_str());
@@ -208,6 +211,7 @@ bool cmCTestAddSubdirectoryCommand
   else
     {
     // No CTestTestfile? Who cares...
+    this->TestHandler->AddMissingTestfileDirectory(fname.c_str());
     cmSystemTools::ChangeDirectory(cwd.c_str());
     return true;
     }
@@ -407,10 +411,17 @@ cmCTestTestHandler::cmCTestTestHandler()
 
   this->CustomMaximumPassedTestOutputSize = 1 * 1024;
   this->CustomMaximumFailedTestOutputSize = 300 * 1024;
+  this->CustomTestHistorySize = 20;
+  this->CustomPerformanceThresholdPercent = 20;
+  this->CustomPerformanceThresholdSigma = 3;
+  this->PerformanceRegressions = 0;
 
   this->MemCheck = false;
 
   this->LogFile = 0;
+  this->RecordManifest = false;
+  this->ShardIndex = 0;
+  this->ShardCount = 0;
 
   // regex to detect <DartMeasurement>...</DartMeasurement>
   this->DartStuff.compile(
@@ -437,6 +448,10 @@ void cmCTestTestHandler::Initialize()
   this->CustomPostTest.clear();
   this->CustomMaximumPassedTestOutputSize = 1 * 1024;
   this->CustomMaximumFailedTestOutputSize = 300 * 1024;
+  this->CustomTestHistorySize = 20;
+  this->CustomPerformanceThresholdPercent = 20;
+  this->CustomPerformanceThresholdSigma = 3;
+  this->PerformanceRegressions = 0;
 
   this->TestsToRun.clear();
 
@@ -451,8 +466,11 @@ void cmCTestTestHandler::Initialize()
   this->ExcludeRegExp = "";
 
   TestsToRunString = "";
+  this->ShardIndex = 0;
+  this->ShardCount = 0;
   this->UseUnion = false;
   this->TestList.clear();
+  this->TestNameIndex.clear();
 }
 
 //----------------------------------------------------------------------
@@ -471,6 +489,15 @@ void cmCTestTestHandler::PopulateCustomVectors(cmMakefile *mf)
   this->CTest->PopulateCustomInteger(mf,
                              "CTEST_CUSTOM_MAXIMUM_FAILED_TEST_OUTPUT_SIZE",
                              this->CustomMaximumFailedTestOutputSize);
+  this->CTest->PopulateCustomInteger(mf,
+                             "CTEST_CUSTOM_TEST_HISTORY_SIZE",
+                             this->CustomTestHistorySize);
+  this->CTest->PopulateCustomInteger(mf,
+                             "CTEST_CUSTOM_PERFORMANCE_THRESHOLD_PERCENT",
+                             this->CustomPerformanceThresholdPercent);
+  this->CTest->PopulateCustomInteger(mf,
+                             "CTEST_CUSTOM_PERFORMANCE_THRESHOLD_SIGMA",
+                             this->CustomPerformanceThresholdSigma);
 }
 
 //----------------------------------------------------------------------
@@ -504,6 +531,13 @@ int cmCTestTestHandler::ProcessHandler()
 {
   // Update internal data structure from generic one
   this->SetTestsToRunInformation(this->GetOption("TestsToRunInformation"));
+  if(!this->SetShardInformation(this->GetOption("ShardInformation")))
+    {
+    cmCTestLog(this->CTest, ERROR_MESSAGE, "Invalid shard: "
+               << this->GetOption("ShardInformation")
+               << ", expected <index>/<count>" << std::endl);
+    return -1;
+    }
   this->SetUseUnion(cmSystemTools::IsOn(this->GetOption("UseUnion")));
   if(cmSystemTools::IsOn(this->GetOption("ScheduleRandom")))
     {
@@ -567,6 +601,11 @@ int cmCTestTestHandler::ProcessHandler()
 
   clock_finish = cmSystemTools::GetTime();
 
+  if ( !this->MemCheck && !this->CTest->GetShowOnly() )
+    {
+    this->UpdateTestHistory();
+    }
+
   total = int(passed.size()) + int(failed.size());
 
   if (total == 0)
@@ -637,6 +676,29 @@ int cmCTestTestHandler::ProcessHandler()
           }
         }
       }
+
+    if (this->PerformanceRegressions)
+      {
+      cmCTestLog(this->CTest, HANDLER_OUTPUT, std::endl
+                 << "The following tests were slower than in earlier runs:"
+                 << std::endl);
+      typedef std::set<cmCTestTestHandler::cmCTestTestResult,
+                       cmCTestTestResultLess> SetOfTests;
+      SetOfTests resultsSet(this->TestResults.begin(),
+                            this->TestResults.end());
+      for(SetOfTests::iterator rit = resultsSet.begin();
+          rit != resultsSet.end(); ++rit)
+        {
+        if ( !rit->PerformanceRegression.empty() )
+          {
+          cmCTestLog(this->CTest, HANDLER_OUTPUT, "\t" << std::setw(3)
+                     << rit->TestCount << " - "
+                     << rit->Name.c_str() << " ("
+                     << rit->PerformanceRegression << ")"
+                     << std::endl);
+          }
+        }
+      }
     }
 
   if ( this->CTest->GetProduceXML() )
@@ -666,6 +728,14 @@ int cmCTestTestHandler::ProcessHandler()
     this->LogFile = 0;
     return -1;
     }
+  if ( this->PerformanceRegressions &&
+    cmSystemTools::IsOn(this->GetOption("FailOnPerformanceRegression")) )
+    {
+    cmCTestLog(this->CTest, ERROR_MESSAGE, this->PerformanceRegressions
+               << " tests were slower than in earlier runs" << std::endl);
+    this->LogFile = 0;
+    return -1;
+    }
   this->LogFile = 0;
   return 0;
 }
@@ -820,6 +890,7 @@ void cmCTestTestHandler::CheckLabelFilter(cmCTestTestProperties& it)
 void cmCTestTestHandler::ComputeTestList()
 {
   this->TestList.clear(); // clear list of test
+  this->TestNameIndex.clear();
   this->GetListOfTests();
   cmCTestTestHandler::ListOfTests::size_type tmsize = this->TestList.size();
   // how many tests are in based on RegExp?
@@ -883,6 +954,10 @@ void cmCTestTestHandler::ComputeTestList()
   this->TotalNumberOfTests = this->TestList.size();
   // Set the TestList to the final list of all test
   this->TestList = finalList;
+  if(this->ShardCount > 1)
+    {
+    this->SelectShard();
+    }
   std::string::size_type max = this->CTest->GetMaxTestNameWidth();
   for (it = this->TestList.begin();
        it != this->TestList.end(); it ++ )
@@ -1162,6 +1237,17 @@ void cmCTestTestHandler::GenerateDartOutput(std::ostream& os)
         << "name=\"Execution Time\"><Value>"
         << result->ExecutionTime
         << "</Value></NamedMeasurement>\n";
+      if(result->HasResourceUsage)
+        {
+        this->WriteResourceUsage(os, result);
+        }
+      if(!result->PerformanceRegression.empty())
+        {
+        os << "\t\t\t<NamedMeasurement type=\"text/string\" "
+           << "name=\"Performance Regression\"><Value>"
+           << cmXMLSafe(result->PerformanceRegression)
+           << "</Value></NamedMeasurement>\n";
+        }
       if(result->Reason.size())
         {
         const char* reasonType = "Pass Reason";
@@ -1222,6 +1308,37 @@ void cmCTestTestHandler::GenerateDartOutput(std::ostream& os)
   this->CTest->EndXML(os);
 }
 
+//----------------------------------------------------------------------------
+void cmCTestTestHandler::WriteResourceUsage(std::ostream& os,
+                                            cmCTestTestResult* result)
+{
+  os << "\t\t\t<NamedMeasurement type=\"numeric/double\" "
+     << "name=\"User Time\"><Value>" << result->UserTime
+     << "</Value></NamedMeasurement>\n"
+     << "\t\t\t<NamedMeasurement type=\"numeric/double\" "
+     << "name=\"System Time\"><Value>" << result->SystemTime
+     << "</Value></NamedMeasurement>\n"
+     << "\t\t\t<NamedMeasurement type=\"numeric/integer\" "
+     << "name=\"Maximum Resident Size\"><Value>" << result->MaxResidentSize
+     << "</Value></NamedMeasurement>\n"
+     << "\t\t\t<NamedMeasurement type=\"numeric/integer\" "
+     << "name=\"Voluntary Context Switches\"><Value>"
+     << result->VoluntaryContextSwitches
+     << "</Value></NamedMeasurement>\n"
+     << "\t\t\t<NamedMeasurement type=\"numeric/integer\" "
+     << "name=\"Involuntary Context Switches\"><Value>"
+     << result->InvoluntaryContextSwitches
+     << "</Value></NamedMeasurement>\n"
+     << "\t\t\t<NamedMeasurement type=\"numeric/integer\" "
+     << "name=\"Block Input Operations\"><Value>"
+     << result->BlockInputOperations
+     << "</Value></NamedMeasurement>\n"
+     << "\t\t\t<NamedMeasurement type=\"numeric/integer\" "
+     << "name=\"Block Output Operations\"><Value>"
+     << result->BlockOutputOperations
+     << "</Value></NamedMeasurement>\n";
+}
+
 //----------------------------------------------------------------------------
 void cmCTestTestHandler::WriteTestResultHeader(std::ostream& os,
                                                cmCTestTestResult* result)
@@ -1541,6 +1658,13 @@ void cmCTestTestHandler::GetListOfTests()
     {
     this->ExcludeTestsRegularExpression.compile(this->ExcludeRegExp.c_str());
     }
+  if ( this->ReadTestManifest() )
+    {
+    cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+      "Read the list of tests from " << this->GetTestManifestFile()
+      << std::endl);
+    return;
+    }
   cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
     "Constructing a list of tests" << std::endl);
   cmake cm;
@@ -1590,7 +1714,15 @@ void cmCTestTestHandler::GetListOfTests()
     return;
     }
 
-  if ( !mf->ReadListFile(0, testFilename) )
+  // Test files modified at or after this time may change again within
+  // the resolution of their time stamps without being noticed.
+  long readTime = static_cast<long>(time(0));
+  this->ManifestEntries.clear();
+  this->ManifestMissingDirectories.clear();
+  this->RecordManifest = true;
+  bool readit = mf->ReadListFile(0, testFilename);
+  this->RecordManifest = false;
+  if ( !readit )
     {
     return;
     }
@@ -1598,10 +1730,812 @@ void cmCTestTestHandler::GetListOfTests()
     {
     return;
     }
+  this->WriteTestManifest(mf, readTime);
   cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
     "Done constructing a list of tests" << std::endl);
 }
 
+//----------------------------------------------------------------------
+bool cmCTestTestHandler::SetShardInformation(const char* in)
+{
+  this->ShardIndex = 0;
+  this->ShardCount = 0;
+  if ( !in )
+    {
+    return true;
+    }
+  int index = 0;
+  int count = 0;
+  char extra;
+  if ( sscanf(in, "%d/%d%c", &index, &count, &extra) != 2 ||
+    count < 1 || index < 1 || index > count )
+    {
+    return false;
+    }
+  this->ShardIndex = index;
+  this->ShardCount = count;
+  return true;
+}
+
+//----------------------------------------------------------------------
+// Union-find lookup used to group tests that must run in the same shard.
+static size_t cmCTestShardGroupOf(std::vector<size_t>& group, size_t i)
+{
+  while ( group[i] != i )
+    {
+    group[i] = group[group[i]];
+    i = group[i];
+    }
+  return i;
+}
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::SelectShard()
+{
+  // Every shard must compute the same split.  The cost data written by
+  // earlier runs differs between the trees running the shards, so only
+  // a cost data file shared by all of them is used to balance the split.
+  // Otherwise only the COST property of the tests is considered.
+  std::map<cmStdString, float> costs;
+  const char* costFile = this->GetOption("ShardCostData");
+  if ( costFile && *costFile )
+    {
+    std::ifstream fin(costFile);
+    if ( !fin )
+      {
+      cmCTestLog(this->CTest, WARNING, "Cannot read shard cost data: "
+        << costFile << std::endl);
+      }
+    std::string line;
+    while ( cmSystemTools::GetLineFromStream(fin, line) && line != "---" )
+      {
+      std::vector<cmsys::String> parts =
+        cmSystemTools::SplitString(line.c_str(), ' ');
+      //Format: <name> <previous_runs> <avg_cost>
+      if ( parts.size() >= 3 )
+        {
+        costs[parts[0]] = static_cast<float>(atof(parts[2].c_str()));
+        }
+      }
+    }
+
+  size_t ntests = this->TestList.size();
+  std::vector<double> testCost(ntests, 0);
+  double knownCost = 0;
+  size_t known = 0;
+  std::map<cmStdString, size_t> byName;
+  for ( size_t i = 0; i < ntests; ++i )
+    {
+    cmCTestTestProperties& p = this->TestList[i];
+    byName[p.Name] = i;
+    std::map<cmStdString, float>::const_iterator c = costs.find(p.Name);
+    testCost[i] = (c != costs.end() && c->second > 0)? c->second : p.Cost;
+    if ( testCost[i] > 0 )
+      {
+      knownCost += testCost[i];
+      ++known;
+      }
+    }
+  // Tests that never ran count as an average one.
+  double defaultCost = known ? knownCost / known : 1;
+
+  // Tests that depend on each other or share a resource lock stay
+  // together so that their ordering and locking still apply.
+  std::vector<size_t> group(ntests);
+  for ( size_t i = 0; i < ntests; ++i )
+    {
+    group[i] = i;
+    }
+  std::map<std::string, size_t> lockOwner;
+  for ( size_t i = 0; i < ntests; ++i )
+    {
+    cmCTestTestProperties& p = this->TestList[i];
+    for ( std::vector<std::string>::const_iterator d = p.Depends.begin();
+      d != p.Depends.end(); ++d )
+      {
+      std::map<cmStdString, size_t>::const_iterator o = byName.find(*d);
+      if ( o != byName.end() )
+        {
+        group[cmCTestShardGroupOf(group, i)] =
+          cmCTestShardGroupOf(group, o->second);
+        }
+      }
+    for ( std::set<std::string>::const_iterator l = p.LockedResources.begin();
+      l != p.LockedResources.end(); ++l )
+      {
+      std::map<std::string, size_t>::iterator o = lockOwner.find(*l);
+      if ( o == lockOwner.end() )
+        {
+        lockOwner[*l] = i;
+        }
+      else
+        {
+        group[cmCTestShardGroupOf(group, i)] =
+          cmCTestShardGroupOf(group, o->second);
+        }
+      }
+    }
+
+  // Sum the cost of each group, identified by its first test.
+  std::map<size_t, size_t> groupIndex;
+  std::vector<size_t> firstOf(ntests);
+  std::vector<std::pair<double, size_t> > groups;
+  for ( size_t i = 0; i < ntests; ++i )
+    {
+    size_t root = cmCTestShardGroupOf(group, i);
+    std::map<size_t, size_t>::iterator g = groupIndex.find(root);
+    if ( g == groupIndex.end() )
+      {
+      g = groupIndex.insert(
+        std::map<size_t, size_t>::value_type(root, groups.size())).first;
+      groups.push_back(std::pair<double, size_t>(0, i));
+      }
+    firstOf[i] = groups[g->second].second;
+    groups[g->second].first -=
+      testCost[i] > 0 ? testCost[i] : defaultCost;
+    }
+
+  // Hand out the most expensive groups first, each to the shard with the
+  // least work so far.  Costs are negated above so that sorting puts the
+  // most expensive first, with ties broken by test order.
+  std::sort(groups.begin(), groups.end());
+  std::vector<double> load(this->ShardCount, 0);
+  std::map<size_t, int> shardOfFirst;
+  for ( size_t g = 0; g < groups.size(); ++g )
+    {
+    int best = 0;
+    for ( int s = 1; s < this->ShardCount; ++s )
+      {
+      if ( load[s] < load[best] )
+        {
+        best = s;
+        }
+      }
+    load[best] -= groups[g].first;
+    shardOfFirst[groups[g].second] = best;
+    }
+
+  ListOfTests shardList;
+  for ( size_t i = 0; i < ntests; ++i )
+    {
+    if ( shardOfFirst[firstOf[i]] == this->ShardIndex - 1 )
+      {
+      shardList.push_back(this->TestList[i]);
+      }
+    }
+  cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT, "Shard "
+    << this->ShardIndex << " of " << this->ShardCount << " runs "
+    << shardList.size() << " of " << ntests << " tests" << std::endl);
+  this->TestList = shardList;
+}
+
+//----------------------------------------------------------------------
+static bool cmCTestReadFileToString(std::string const& fname,
+                                    std::string& content)
+{
+  std::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
+  if ( !fin )
+    {
+    return false;
+    }
+  cmOStringStream ostr;
+  ostr << fin.rdbuf();
+  content = ostr.str();
+  return true;
+}
+
+//----------------------------------------------------------------------
+static unsigned long cmCTestXMLTagValue(std::string const& xml,
+                                        const char* tag)
+{
+  std::string::size_type pos = xml.find(tag);
+  if ( pos == std::string::npos )
+    {
+    return 0;
+    }
+  return strtoul(xml.c_str() + pos + strlen(tag), 0, 10);
+}
+
+//----------------------------------------------------------------------
+int cmCTestTestHandler::MergeResults(std::vector<std::string> const& dirs)
+{
+  std::string binDir = cmSystemTools::GetCurrentWorkingDirectory();
+  std::string tagFileContent;
+  std::string tag;
+  std::string header;
+  std::string footer;
+  std::string testList;
+  std::string testResults;
+  std::string log;
+  unsigned long startTime = 0;
+  unsigned long endTime = 0;
+  std::map<cmStdString, std::pair<int, std::string> > costs;
+  std::vector<cmStdString> costOrder;
+  std::vector<cmStdString> failed;
+  std::set<cmStdString> failedSet;
+  std::map<cmStdString, std::pair<size_t, std::string> > history;
+  std::vector<cmStdString> historyOrder;
+
+  for ( std::vector<std::string>::const_iterator d = dirs.begin();
+    d != dirs.end(); ++d )
+    {
+    // Each shard ran in its own build tree with its own tag.
+    std::string dir = cmSystemTools::CollapseFullPath(d->c_str());
+    std::string tagFile = dir + "/Testing/TAG";
+    std::string content;
+    std::string shardTag;
+    if ( !cmCTestReadFileToString(tagFile, content) )
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot read " << tagFile
+        << std::endl);
+      return 1;
+      }
+    shardTag = content.substr(0, content.find_first_of("\r\n"));
+    if ( tag.empty() )
+      {
+      tag = shardTag;
+      tagFileContent = content;
+      }
+
+    // The Test.xml file written by GenerateDartOutput has a header up to
+    // the test list, the list itself, one element per test and a footer
+    // starting at the end time.
+    std::string xmlFile = dir + "/Testing/" + shardTag + "/Test.xml";
+    std::string xml;
+    std::string::size_type listBegin = std::string::npos;
+    std::string::size_type listEnd = std::string::npos;
+    std::string::size_type footBegin = std::string::npos;
+    if ( cmCTestReadFileToString(xmlFile, xml) )
+      {
+      listBegin = xml.find("\t<TestList>\n");
+      listEnd = xml.find("\t</TestList>\n");
+      footBegin = xml.rfind("\t<EndDateTime>");
+      }
+    if ( listBegin == std::string::npos || listEnd == std::string::npos ||
+      footBegin == std::string::npos || listEnd < listBegin ||
+      footBegin < listEnd )
+      {
+      cmCTestLog(this->CTest, ERROR_MESSAGE, "Cannot read test results from "
+        << xmlFile << std::endl);
+      return 1;
+      }
+    listBegin += strlen("\t<TestList>\n");
+    std::string::size_type resultsBegin = listEnd + strlen("\t</TestList>\n");
+    unsigned long shardStart = cmCTestXMLTagValue(xml, "<StartTestTime>");
+    unsigned long shardEnd = cmCTestXMLTagValue(xml, "<EndTestTime>");
+    if ( header.empty() || shardStart < startTime )
+      {
+      header = xml.substr(0, listBegin);
+      startTime = shardStart;
+      }
+    if ( footer.empty() || shardEnd > endTime )
+      {
+      footer = xml.substr(footBegin);
+      endTime = shardEnd;
+      }
+    testList += xml.substr(listBegin, listEnd - listBegin);
+    testResults += xml.substr(resultsBegin, footBegin - resultsBegin);
+
+    if ( cmCTestReadFileToString(
+        dir + "/Testing/Temporary/LastTest_" + shardTag + ".log", content) )
+      {
+      log += content;
+      }
+
+    // Keep the cost entry with the most runs, that is the one written by
+    // the shard that actually ran the test.
+    std::ifstream fin((dir + "/Testing/Temporary/CTestCostData.txt").c_str());
+    std::string line;
+    while ( cmSystemTools::GetLineFromStream(fin, line) && line != "---" )
+      {
+      std::vector<cmsys::String> parts =
+        cmSystemTools::SplitString(line.c_str(), ' ');
+      if ( parts.size() < 3 )
+        {
+        continue;
+        }
+      int runs = atoi(parts[1].c_str());
+      std::map<cmStdString, std::pair<int, std::string> >::iterator c =
+        costs.find(parts[0]);
+      if ( c == costs.end() )
+        {
+        costOrder.push_back(parts[0]);
+        costs[parts[0]] = std::pair<int, std::string>(runs, line);
+        }
+      else if ( runs > c->second.first )
+        {
+        c->second = std::pair<int, std::string>(runs, line);
+        }
+      }
+    while ( cmSystemTools::GetLineFromStream(fin, line) )
+      {
+      if ( !line.empty() && failedSet.insert(line).second )
+        {
+        failed.push_back(line);
+        }
+      }
+
+    // Likewise keep the longest timing history of each test.
+    std::ifstream hin(
+      (dir + "/Testing/Temporary/CTestTestHistory.txt").c_str());
+    while ( cmSystemTools::GetLineFromStream(hin, line) )
+      {
+      std::vector<cmsys::String> parts =
+        cmSystemTools::SplitString(line.c_str(), ' ');
+      if ( parts.size() < 2 )
+        {
+        continue;
+        }
+      std::map<cmStdString, std::pair<size_t, std::string> >::iterator h =
+        history.find(parts[0]);
+      if ( h == history.end() )
+        {
+        historyOrder.push_back(parts[0]);
+        history[parts[0]] =
+          std::pair<size_t, std::string>(parts.size(), line);
+        }
+      else if ( parts.size() > h->second.first )
+        {
+        h->second = std::pair<size_t, std::string>(parts.size(), line);
+        }
+      }
+    }
+
+  if ( tag.empty() )
+    {
+    return 0;
+    }
+
+  std::string testingDir = binDir + "/Testing";
+  cmSystemTools::MakeDirectory((testingDir + "/" + tag).c_str());
+  cmSystemTools::MakeDirectory((testingDir + "/Temporary").c_str());
+  {
+  cmGeneratedFileStream tfout((testingDir + "/TAG").c_str());
+  tfout << tagFileContent;
+  }
+  {
+  cmGeneratedFileStream xout((testingDir + "/" + tag + "/Test.xml").c_str());
+  xout << header << testList << "\t</TestList>\n" << testResults << footer;
+  }
+  {
+  cmGeneratedFileStream lout(
+    (testingDir + "/Temporary/LastTest_" + tag + ".log").c_str());
+  lout << log;
+  }
+  {
+  cmGeneratedFileStream cfout(
+    (testingDir + "/Temporary/CTestCostData.txt").c_str());
+  for ( std::vector<cmStdString>::const_iterator c = costOrder.begin();
+    c != costOrder.end(); ++c )
+    {
+    cfout << costs[*c].second << "\n";
+    }
+  cfout << "---\n";
+  for ( std::vector<cmStdString>::const_iterator f = failed.begin();
+    f != failed.end(); ++f )
+    {
+    cfout << *f << "\n";
+    }
+  }
+  if ( !history.empty() )
+    {
+    cmGeneratedFileStream hout(
+      (testingDir + "/Temporary/CTestTestHistory.txt").c_str());
+    for ( std::vector<cmStdString>::const_iterator h = historyOrder.begin();
+      h != historyOrder.end(); ++h )
+      {
+      hout << history[*h].second << "\n";
+      }
+    }
+  cmCTestLog(this->CTest, HANDLER_OUTPUT, "Merged test results of "
+    << dirs.size() << " shards into " << testingDir << "/" << tag
+    << "/Test.xml" << std::endl);
+  return 0;
+}
+
+//----------------------------------------------------------------------
+std::string cmCTestTestHandler::GetTestHistoryFile()
+{
+  return this->CTest->GetBinaryDir() +
+    "/Testing/Temporary/CTestTestHistory.txt";
+}
+
+//----------------------------------------------------------------------
+struct cmCTestTestHistorySample
+{
+  double Time;
+  long ResidentSize;
+};
+
+//----------------------------------------------------------------------
+// Return true if the value is significantly above the given samples of
+// earlier runs: by more than the given number of standard deviations,
+// more than the given percentage of their mean and more than the given
+// absolute amount.  Either relative threshold may be disabled with 0.
+static bool cmCTestTestHistoryIsRegression(std::vector<double> const& samples,
+                                           double value, int sigma,
+                                           int percent, double minimum,
+                                           double& mean)
+{
+  double sum = 0;
+  std::vector<double>::const_iterator s;
+  for ( s = samples.begin(); s != samples.end(); ++s )
+    {
+    sum += *s;
+    }
+  mean = sum / samples.size();
+  double variance = 0;
+  for ( s = samples.begin(); s != samples.end(); ++s )
+    {
+    variance += (*s - mean) * (*s - mean);
+    }
+  double deviation = sqrt(variance / samples.size());
+  return value - mean > minimum &&
+    value > mean + sigma * deviation &&
+    value > mean * (1 + percent / 100.0);
+}
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::UpdateTestHistory()
+{
+  this->PerformanceRegressions = 0;
+  if ( this->CustomTestHistorySize <= 0 )
+    {
+    return;
+    }
+
+  // Each line holds a test name followed by the time in seconds and the
+  // resident size in KB of its last passing runs, oldest first.  A size
+  // of 0 means it was not measured.
+  typedef cmCTestTestHistorySample Sample;
+  std::vector<cmStdString> names;
+  std::map<cmStdString, std::vector<Sample> > history;
+  std::string fname = this->GetTestHistoryFile();
+  std::ifstream fin(fname.c_str());
+  std::string line;
+  while ( cmSystemTools::GetLineFromStream(fin, line) )
+    {
+    std::vector<cmsys::String> parts =
+      cmSystemTools::SplitString(line.c_str(), ' ');
+    if ( parts.size() < 2 || history.find(parts[0]) != history.end() )
+      {
+      continue;
+      }
+    names.push_back(parts[0]);
+    std::vector<Sample>& samples = history[parts[0]];
+    for ( size_t i = 1; i < parts.size(); ++i )
+      {
+      Sample sample;
+      sample.Time = atof(parts[i].c_str());
+      std::string::size_type comma = parts[i].find(',');
+      sample.ResidentSize = comma == std::string::npos ? 0 :
+        atol(parts[i].c_str() + comma + 1);
+      samples.push_back(sample);
+      }
+    }
+  fin.close();
+
+  // Earlier runs are only trusted once there are enough of them.
+  const size_t minimumSamples = 5;
+  for ( TestResultsVector::iterator result = this->TestResults.begin();
+    result != this->TestResults.end(); ++result )
+    {
+    if ( result->Status != cmCTestTestHandler::COMPLETED )
+      {
+      continue;
+      }
+    if ( history.find(result->Name) == history.end() )
+      {
+      names.push_back(result->Name);
+      }
+    std::vector<Sample>& samples = history[result->Name];
+    if ( samples.size() >= minimumSamples )
+      {
+      std::vector<double> times;
+      std::vector<double> sizes;
+      for ( std::vector<Sample>::iterator s = samples.begin();
+        s != samples.end(); ++s )
+        {
+        times.push_back(s->Time);
+        if ( s->ResidentSize > 0 )
+          {
+          sizes.push_back(static_cast<double>(s->ResidentSize));
+          }
+        }
+      cmOStringStream msg;
+      double mean;
+      // Ignore differences below the resolution of the timing and of
+      // the resident size that are just noise.
+      if ( cmCTestTestHistoryIsRegression(times, result->ExecutionTime,
+          this->CustomPerformanceThresholdSigma,
+          this->CustomPerformanceThresholdPercent, 0.1, mean) )
+        {
+        msg << "time " << result->ExecutionTime << " sec, mean " << mean
+          << " sec over " << times.size() << " runs";
+        }
+      if ( result->HasResourceUsage && sizes.size() == samples.size() &&
+        cmCTestTestHistoryIsRegression(sizes,
+          static_cast<double>(result->MaxResidentSize),
+          this->CustomPerformanceThresholdSigma,
+          this->CustomPerformanceThresholdPercent, 1024, mean) )
+        {
+        msg << (msg.str().empty() ? "" : "; ")
+          << "resident size " << result->MaxResidentSize << " KB, mean "
+          << static_cast<long>(mean) << " KB over " << sizes.size()
+          << " runs";
+        }
+      result->PerformanceRegression = msg.str();
+      if ( !result->PerformanceRegression.empty() )
+        {
+        ++this->PerformanceRegressions;
+        }
+      }
+    Sample sample;
+    sample.Time = result->ExecutionTime;
+    sample.ResidentSize =
+      result->HasResourceUsage ? result->MaxResidentSize : 0;
+    samples.push_back(sample);
+    if ( samples.size() > static_cast<size_t>(this->CustomTestHistorySize) )
+      {
+      samples.erase(samples.begin(), samples.end() -
+        this->CustomTestHistorySize);
+      }
+    }
+
+  cmGeneratedFileStream fout(fname.c_str());
+  for ( std::vector<cmStdString>::const_iterator n = names.begin();
+    n != names.end(); ++n )
+    {
+    fout << *n;
+    std::vector<Sample> const& samples = history[*n];
+    for ( std::vector<Sample>::const_iterator s = samples.begin();
+      s != samples.end(); ++s )
+      {
+      fout << " " << s->Time << "," << s->ResidentSize;
+      }
+    fout << "\n";
+    }
+}
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::AddMissingTestfileDirectory(const char* dir)
+{
+  if ( this->RecordManifest )
+    {
+    this->ManifestMissingDirectories.push_back(dir);
+    }
+}
+
+//----------------------------------------------------------------------
+std::string cmCTestTestHandler::GetTestManifestFile()
+{
+  return this->CTest->GetBinaryDir() +
+    "/Testing/Temporary/CTestTestManifest.txt";
+}
+
+//----------------------------------------------------------------------
+// Strings are stored with their length in front so that they may hold
+// any character, including newlines.
+static void cmCTestTestManifestWrite(std::ostream& fout,
+                                     std::string const& str)
+{
+  fout << str.size() << " " << str << "\n";
+}
+
+static bool cmCTestTestManifestRead(std::istream& fin, std::string& str)
+{
+  size_t len;
+  if ( !(fin >> len) || fin.get() != ' ' )
+    {
+    return false;
+    }
+  str.resize(len);
+  if ( len > 0 && !fin.read(&str[0], static_cast<std::streamsize>(len)) )
+    {
+    return false;
+    }
+  return fin.get() == '\n';
+}
+
+//----------------------------------------------------------------------
+// The manifest replays only the tests and their properties, so it can
+// stand for test files that use no other commands and nothing from the
+// environment.
+static bool cmCTestTestManifestCanReplay(
+  std::vector<std::string> const& listFiles, cmMakefile* mf)
+{
+  for ( std::vector<std::string>::const_iterator f = listFiles.begin();
+    f != listFiles.end(); ++f )
+    {
+    cmListFile lf;
+    if ( !lf.ParseFile(f->c_str(), false, mf) )
+      {
+      return false;
+      }
+    for ( std::vector<cmListFileFunction>::const_iterator fn =
+        lf.Functions.begin(); fn != lf.Functions.end(); ++fn )
+      {
+      std::string name = cmSystemTools::LowerCase(fn->Name);
+      if ( name != "add_test" && name != "set_tests_properties" &&
+        name != "subdirs" && name != "add_subdirectory" )
+        {
+        return false;
+        }
+      for ( std::vector<cmListFileArgument>::const_iterator a =
+          fn->Arguments.begin(); a != fn->Arguments.end(); ++a )
+        {
+        if ( a->Value.find("$ENV{") != std::string::npos )
+          {
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------
+void cmCTestTestHandler::WriteTestManifest(cmMakefile* mf, long readTime)
+{
+  std::string fname = this->GetTestManifestFile();
+  std::vector<std::string> const& listFiles = mf->GetListFiles();
+  if ( !cmCTestTestManifestCanReplay(listFiles, mf) )
+    {
+    cmSystemTools::RemoveFile(fname.c_str());
+    return;
+    }
+  cmSystemTools::MakeDirectory(cmSystemTools::GetFilenamePath(fname).c_str());
+  cmGeneratedFileStream fout(fname.c_str());
+  if ( !fout )
+    {
+    return;
+    }
+  fout.SetCopyIfDifferent(true);
+
+  // The manifest is only valid for the same configuration, the same
+  // starting directory and unchanged test files.
+  fout << "CTestTestManifest 3\n";
+  fout << readTime << "\n";
+  cmCTestTestManifestWrite(fout, this->CTest->GetConfigType());
+  cmCTestTestManifestWrite(fout,
+                           cmSystemTools::GetCurrentWorkingDirectory());
+  fout << listFiles.size() << "\n";
+  for ( std::vector<std::string>::const_iterator f = listFiles.begin();
+    f != listFiles.end(); ++f )
+    {
+    fout << cmSystemTools::ModifiedTime(f->c_str()) << " "
+      << cmSystemTools::FileLength(f->c_str()) << " ";
+    cmCTestTestManifestWrite(fout, *f);
+    }
+  fout << this->ManifestMissingDirectories.size() << "\n";
+  for ( std::vector<std::string>::const_iterator d =
+      this->ManifestMissingDirectories.begin();
+    d != this->ManifestMissingDirectories.end(); ++d )
+    {
+    cmCTestTestManifestWrite(fout, *d);
+    }
+  fout << this->ManifestEntries.size() << "\n";
+  for ( std::vector<ManifestEntry>::const_iterator e =
+      this->ManifestEntries.begin(); e != this->ManifestEntries.end(); ++e )
+    {
+    fout << (e->IsTest? "T " : "P ") << e->Args.size() << "\n";
+    cmCTestTestManifestWrite(fout, e->Directory);
+    for ( std::vector<std::string>::const_iterator a = e->Args.begin();
+      a != e->Args.end(); ++a )
+      {
+      cmCTestTestManifestWrite(fout, *a);
+      }
+    }
+}
+
+//----------------------------------------------------------------------
+bool cmCTestTestHandler::ReadTestManifest()
+{
+  std::ifstream fin(this->GetTestManifestFile().c_str(),
+                    std::ios::in | std::ios::binary);
+  std::string line;
+  long readTime;
+  if ( !cmSystemTools::GetLineFromStream(fin, line) ||
+    line != "CTestTestManifest 3" || !(fin >> readTime) ||
+    fin.get() != '\n' )
+    {
+    return false;
+    }
+  std::string value;
+  if ( !cmCTestTestManifestRead(fin, value) ||
+    value != this->CTest->GetConfigType() )
+    {
+    return false;
+    }
+  std::string cwd = cmSystemTools::GetCurrentWorkingDirectory();
+  if ( !cmCTestTestManifestRead(fin, value) || value != cwd )
+    {
+    return false;
+    }
+
+  // Every test file read must be unchanged.  A file whose time stamp is
+  // not older than the time it was read may have been rewritten in the
+  // same second, so it is never trusted.
+  size_t count;
+  if ( !(fin >> count) )
+    {
+    return false;
+    }
+  for ( size_t i = 0; i < count; ++i )
+    {
+    long mtime;
+    unsigned long length;
+    if ( !(fin >> mtime >> length) || fin.get() != ' ' ||
+      !cmCTestTestManifestRead(fin, value) ||
+      mtime >= readTime ||
+      cmSystemTools::ModifiedTime(value.c_str()) != mtime ||
+      cmSystemTools::FileLength(value.c_str()) != length )
+      {
+      return false;
+      }
+    }
+
+  // Directories that had no test file must still have none.
+  if ( !(fin >> count) )
+    {
+    return false;
+    }
+  for ( size_t i = 0; i < count; ++i )
+    {
+    if ( !cmCTestTestManifestRead(fin, value) ||
+      cmSystemTools::FileExists((value + "/CTestTestfile.cmake").c_str()) ||
+      cmSystemTools::FileExists((value + "/DartTestfile.txt").c_str()) )
+      {
+      return false;
+      }
+    }
+
+  std::vector<ManifestEntry> entries;
+  if ( !(fin >> count) )
+    {
+    return false;
+    }
+  entries.resize(count);
+  for ( size_t i = 0; i < count; ++i )
+    {
+    ManifestEntry& e = entries[i];
+    char kind;
+    size_t nargs;
+    if ( !(fin >> kind >> nargs) || fin.get() != '\n' ||
+      !cmCTestTestManifestRead(fin, e.Directory) )
+      {
+      return false;
+      }
+    e.IsTest = (kind == 'T');
+    e.Args.resize(nargs);
+    for ( size_t a = 0; a < nargs; ++a )
+      {
+      if ( !cmCTestTestManifestRead(fin, e.Args[a]) )
+        {
+        return false;
+        }
+      }
+    }
+
+  // Replay the commands.  AddTest takes the test directory from the
+  // current working directory just like when the test files are read.
+  for ( std::vector<ManifestEntry>::const_iterator e = entries.begin();
+    e != entries.end(); ++e )
+    {
+    if ( e->IsTest )
+      {
+      cmSystemTools::ChangeDirectory(e->Directory.c_str());
+      this->AddTest(e->Args);
+      }
+    else
+      {
+      this->SetTestsProperties(e->Args);
+      }
+    }
+  cmSystemTools::ChangeDirectory(cwd.c_str());
+  return true;
+}
+
 //----------------------------------------------------------------------
 void cmCTestTestHandler::UseIncludeRegExp()
 {
@@ -1996,6 +2930,13 @@ bool cmCTestTestHandler::CleanTestOutput(std::string& output, size_t length)
 bool cmCTestTestHandler::SetTestsProperties(
   const std::vector<std::string>& args)
 {
+  if ( this->RecordManifest )
+    {
+    ManifestEntry e;
+    e.IsTest = false;
+    e.Args = args;
+    this->ManifestEntries.push_back(e);
+    }
   std::vector<std::string>::const_iterator it;
   std::vector<cmStdString> tests;
   bool found = false;
@@ -2025,157 +2966,160 @@ bool cmCTestTestHandler::SetTestsProperties(
     std::vector<cmStdString>::const_iterator tit;
     for ( tit = tests.begin(); tit != tests.end(); ++ tit )
       {
-      cmCTestTestHandler::ListOfTests::iterator rtit;
-      for ( rtit = this->TestList.begin();
-        rtit != this->TestList.end();
-        ++ rtit )
+      TestNameIndexType::const_iterator nit =
+        this->TestNameIndex.find(*tit);
+      if ( nit == this->TestNameIndex.end() )
+        {
+        continue;
+        }
+      std::vector<size_t>::const_iterator iit;
+      for ( iit = nit->second.begin(); iit != nit->second.end(); ++ iit )
         {
-        if ( *tit == rtit->Name )
+        cmCTestTestHandler::ListOfTests::iterator rtit =
+          this->TestList.begin() + *iit;
+        if ( key == "WILL_FAIL" )
           {
-          if ( key == "WILL_FAIL" )
-            {
-            rtit->WillFail = cmSystemTools::IsOn(val.c_str());
-            }
-          if ( key == "ATTACHED_FILES" )
-            {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
+          rtit->WillFail = cmSystemTools::IsOn(val.c_str());
+          }
+        if ( key == "ATTACHED_FILES" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
 
-            for(std::vector<std::string>::iterator f = lval.begin();
-                f != lval.end(); ++f)
-              {
-              rtit->AttachedFiles.push_back(*f);
-              }
-            }
-          if ( key == "ATTACHED_FILES_ON_FAIL" )
+          for(std::vector<std::string>::iterator f = lval.begin();
+              f != lval.end(); ++f)
             {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
-
-            for(std::vector<std::string>::iterator f = lval.begin();
-                f != lval.end(); ++f)
-              {
-              rtit->AttachOnFail.push_back(*f);
-              }
+            rtit->AttachedFiles.push_back(*f);
             }
-          if ( key == "RESOURCE_LOCK" )
-            {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
+          }
+        if ( key == "ATTACHED_FILES_ON_FAIL" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
 
-            for(std::vector<std::string>::iterator f = lval.begin();
-                f != lval.end(); ++f)
-              {
-              rtit->LockedResources.insert(*f);
-              }
-            }
-          if ( key == "TIMEOUT" )
+          for(std::vector<std::string>::iterator f = lval.begin();
+              f != lval.end(); ++f)
             {
-            rtit->Timeout = atof(val.c_str());
-            rtit->ExplicitTimeout = true;
+            rtit->AttachOnFail.push_back(*f);
             }
-          if ( key == "COST" )
+          }
+        if ( key == "RESOURCE_LOCK" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
+
+          for(std::vector<std::string>::iterator f = lval.begin();
+              f != lval.end(); ++f)
             {
-            rtit->Cost = static_cast<float>(atof(val.c_str()));
+            rtit->LockedResources.insert(*f);
             }
-          if ( key == "REQUIRED_FILES" )
-            {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
+          }
+        if ( key == "TIMEOUT" )
+          {
+          rtit->Timeout = atof(val.c_str());
+          rtit->ExplicitTimeout = true;
+          }
+        if ( key == "COST" )
+          {
+          rtit->Cost = static_cast<float>(atof(val.c_str()));
+          }
+        if ( key == "REQUIRED_FILES" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
 
-            for(std::vector<std::string>::iterator f = lval.begin();
-                f != lval.end(); ++f)
-              {
-              rtit->RequiredFiles.push_back(*f);
-              }
-            }
-          if ( key == "RUN_SERIAL" )
+          for(std::vector<std::string>::iterator f = lval.begin();
+              f != lval.end(); ++f)
             {
-            rtit->RunSerial = cmSystemTools::IsOn(val.c_str());
+            rtit->RequiredFiles.push_back(*f);
             }
-          if ( key == "FAIL_REGULAR_EXPRESSION" )
+          }
+        if ( key == "RUN_SERIAL" )
+          {
+          rtit->RunSerial = cmSystemTools::IsOn(val.c_str());
+          }
+        if ( key == "FAIL_REGULAR_EXPRESSION" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
+          std::vector<std::string>::iterator crit;
+          for ( crit = lval.begin(); crit != lval.end(); ++ crit )
             {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
-            std::vector<std::string>::iterator crit;
-            for ( crit = lval.begin(); crit != lval.end(); ++ crit )
-              {
-              rtit->ErrorRegularExpressions.push_back(
-                std::pair<cmsys::RegularExpression, std::string>(
-                  cmsys::RegularExpression(crit->c_str()),
-                  std::string(crit->c_str())));
-              }
+            rtit->ErrorRegularExpressions.push_back(
+              std::pair<cmsys::RegularExpression, std::string>(
+                cmsys::RegularExpression(crit->c_str()),
+                std::string(crit->c_str())));
             }
-          if ( key == "PROCESSORS" )
+          }
+        if ( key == "PROCESSORS" )
+          {
+          rtit->Processors = atoi(val.c_str());
+          if(rtit->Processors < 1)
             {
-            rtit->Processors = atoi(val.c_str());
-            if(rtit->Processors < 1)
-              {
-              rtit->Processors = 1;
-              }
+            rtit->Processors = 1;
             }
-          if ( key == "DEPENDS" )
+          }
+        if ( key == "DEPENDS" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
+          std::vector<std::string>::iterator crit;
+          for ( crit = lval.begin(); crit != lval.end(); ++ crit )
             {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
-            std::vector<std::string>::iterator crit;
-            for ( crit = lval.begin(); crit != lval.end(); ++ crit )
-              {
-              rtit->Depends.push_back(*crit);
-              }
+            rtit->Depends.push_back(*crit);
             }
-          if ( key == "ENVIRONMENT" )
+          }
+        if ( key == "ENVIRONMENT" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
+          std::vector<std::string>::iterator crit;
+          for ( crit = lval.begin(); crit != lval.end(); ++ crit )
             {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
-            std::vector<std::string>::iterator crit;
-            for ( crit = lval.begin(); crit != lval.end(); ++ crit )
-              {
-              rtit->Environment.push_back(*crit);
-              }
+            rtit->Environment.push_back(*crit);
             }
-          if ( key == "LABELS" )
+          }
+        if ( key == "LABELS" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
+          std::vector<std::string>::iterator crit;
+          for ( crit = lval.begin(); crit != lval.end(); ++ crit )
             {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
-            std::vector<std::string>::iterator crit;
-            for ( crit = lval.begin(); crit != lval.end(); ++ crit )
-              {
-              rtit->Labels.push_back(*crit);
-              }
+            rtit->Labels.push_back(*crit);
             }
-          if ( key == "MEASUREMENT" )
+          }
+        if ( key == "MEASUREMENT" )
+          {
+          size_t pos = val.find_first_of("=");
+          if ( pos != val.npos )
             {
-            size_t pos = val.find_first_of("=");
-            if ( pos != val.npos )
-              {
-              std::string mKey = val.substr(0, pos);
-              const char* mVal = val.c_str() + pos + 1;
-              rtit->Measurements[mKey] = mVal;
-              }
-            else
-              {
-              rtit->Measurements[val] = "1";
-              }
+            std::string mKey = val.substr(0, pos);
+            const char* mVal = val.c_str() + pos + 1;
+            rtit->Measurements[mKey] = mVal;
             }
-          if ( key == "PASS_REGULAR_EXPRESSION" )
+          else
             {
-            std::vector<std::string> lval;
-            cmSystemTools::ExpandListArgument(val.c_str(), lval);
-            std::vector<std::string>::iterator crit;
-            for ( crit = lval.begin(); crit != lval.end(); ++ crit )
-              {
-              rtit->RequiredRegularExpressions.push_back(
-                std::pair<cmsys::RegularExpression, std::string>(
-                  cmsys::RegularExpression(crit->c_str()),
-                  std::string(crit->c_str())));
-              }
+            rtit->Measurements[val] = "1";
             }
-          if ( key == "WORKING_DIRECTORY" )
+          }
+        if ( key == "PASS_REGULAR_EXPRESSION" )
+          {
+          std::vector<std::string> lval;
+          cmSystemTools::ExpandListArgument(val.c_str(), lval);
+          std::vector<std::string>::iterator crit;
+          for ( crit = lval.begin(); crit != lval.end(); ++ crit )
             {
-            rtit->Directory = val;
+            rtit->RequiredRegularExpressions.push_back(
+              std::pair<cmsys::RegularExpression, std::string>(
+                cmsys::RegularExpression(crit->c_str()),
+                std::string(crit->c_str())));
             }
           }
+        if ( key == "WORKING_DIRECTORY" )
+          {
+          rtit->Directory = val;
+          }
         }
       }
     }
@@ -2188,6 +3132,15 @@ bool cmCTestTestHandler::AddTest(const std::vector<std::string>& args)
   const std::string& testname = args[0];
   cmCTestLog(this->CTest, DEBUG, "Add test: " << args[0] << std::endl);
 
+  if ( this->RecordManifest )
+    {
+    ManifestEntry e;
+    e.IsTest = true;
+    e.Directory = cmSystemTools::GetCurrentWorkingDirectory();
+    e.Args = args;
+    this->ManifestEntries.push_back(e);
+    }
+
   if (this->UseExcludeRegExpFlag &&
     this->UseExcludeRegExpFirst &&
     this->ExcludeTestsRegularExpression.find(testname.c_str()))
@@ -2250,6 +3203,8 @@ bool cmCTestTestHandler::AddTest(const std::vector<std::string>& args)
   test.Cost = 0;
   test.Processors = 1;
   test.PreviousRuns = 0;
+  test.CPUCost = 0;
+  test.MaxResidentSize = 0;
   if (this->UseIncludeRegExpFlag &&
     !this->IncludeTestsRegularExpression.find(testname.c_str()))
     {
@@ -2261,6 +3216,7 @@ bool cmCTestTestHandler::AddTest(const std::vector<std::string>& args)
     {
     test.IsInBasedOnREOptions = false;
     }
+  this->TestNameIndex[testname].push_back(this->TestList.size());
   this->TestList.push_back(test);
   return true;
 }
@@ -61,6 +61,15 @@ public:
   ///! pass the -I argument down
   void SetTestsToRunInformation(const char*);
 
+  ///! pass the --shard argument down, in the form index/count
+  bool SetShardInformation(const char*);
+
+  /**
+   * Combine the test results of several build trees that each ran one
+   * shard of the tests into the current directory.
+   */
+  int MergeResults(std::vector<std::string> const& dirs);
+
   cmCTestTestHandler();
 
   /*
@@ -73,6 +82,11 @@ public:
    */
   bool SetTestsProperties(const std::vector<std::string>& args);
 
+  /*
+   * Record a directory that was searched for a test file without success
+   */
+  void AddMissingTestfileDirectory(const char* dir);
+
   void Initialize();
 
   // NOTE: This struct is Saved/Restored
@@ -97,6 +111,10 @@ public:
     bool WillFail;
     float Cost;
     int PreviousRuns;
+    // Average processor time and largest resident size (KB) of
+    // previous runs, as recorded in the cost data file
+    float CPUCost;
+    long MaxResidentSize;
     bool RunSerial;
     double Timeout;
     bool ExplicitTimeout;
@@ -123,6 +141,17 @@ public:
     std::string RegressionImages;
     int         TestCount;
     cmCTestTestProperties* Properties;
+    // Resources used by the test process, valid if HasResourceUsage
+    bool        HasResourceUsage;
+    double      UserTime;
+    double      SystemTime;
+    long        MaxResidentSize;
+    long        VoluntaryContextSwitches;
+    long        InvoluntaryContextSwitches;
+    long        BlockInputOperations;
+    long        BlockOutputOperations;
+    // Description of how the test was slower than in earlier runs, if so
+    std::string PerformanceRegression;
   };
 
   struct cmCTestTestResultLess
@@ -157,6 +186,7 @@ protected:
   int ExecuteCommands(std::vector<cmStdString>& vec);
 
   void WriteTestResultHeader(std::ostream& os, cmCTestTestResult* result);
+  void WriteResourceUsage(std::ostream& os, cmCTestTestResult* result);
   void WriteTestResultFooter(std::ostream& os, cmCTestTestResult* result);
   // Write attached test files into the xml
   void AttachFiles(std::ostream& os, cmCTestTestResult* result);
@@ -177,6 +207,10 @@ protected:
   bool MemCheck;
   int CustomMaximumPassedTestOutputSize;
   int CustomMaximumFailedTestOutputSize;
+  int CustomTestHistorySize;
+  int CustomPerformanceThresholdPercent;
+  int CustomPerformanceThresholdSigma;
+  int PerformanceRegressions;
   int MaxIndex;
 public:
   enum { // Program statuses
@@ -209,10 +243,36 @@ private:
    * Get the list of tests in directory and subdirectories.
    */
   void GetListOfTests();
+
+  // The add_test and set_tests_properties calls seen while reading the
+  // test files are saved in a manifest together with the files they came
+  // from.  Later runs replay them instead of reading the files again.
+  struct ManifestEntry
+  {
+    bool IsTest;
+    std::string Directory;
+    std::vector<std::string> Args;
+  };
+  std::vector<ManifestEntry> ManifestEntries;
+  std::vector<std::string> ManifestMissingDirectories;
+  bool RecordManifest;
+  std::string GetTestManifestFile();
+  bool ReadTestManifest();
+  void WriteTestManifest(cmMakefile* mf, long readTime);
   // compute the lists of tests that will actually run
   // based on union regex and -I stuff
   void ComputeTestList();
 
+  // record the timing of the tests run in the history of earlier runs
+  // and flag those that became significantly slower
+  std::string GetTestHistoryFile();
+  void UpdateTestHistory();
+
+  // keep only the tests assigned to this shard
+  void SelectShard();
+  int ShardIndex;
+  int ShardCount;
+
   bool GetValue(const char* tag,
                 std::string& value,
                 std::ifstream& fin);
@@ -264,6 +324,9 @@ private:
   std::string TestsToRunString;
   bool UseUnion;
   ListOfTests TestList;
+  // Positions in TestList of the tests with each name.
+  typedef std::map<cmStdString, std::vector<size_t> > TestNameIndexType;
+  TestNameIndexType TestNameIndex;
   size_t TotalNumberOfTests;
   cmsys::RegularExpression DartStuff;
 
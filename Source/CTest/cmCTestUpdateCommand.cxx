@@ -53,6 +53,8 @@ cmCTestGenericHandler* cmCTestUpdateCommand::InitializeHandler()
     "GITUpdateOptions", "CTEST_GIT_UPDATE_OPTIONS");
   this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
     "GITUpdateCustom", "CTEST_GIT_UPDATE_CUSTOM");
+  this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
+    "GITUpdateRevisionLimit", "CTEST_GIT_UPDATE_REVISION_LIMIT");
   this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
     "HGCommand", "CTEST_HG_COMMAND");
   this->CTest->SetCTestConfigurationFromCMakeVariable(this->Makefile,
@@ -21,6 +21,8 @@ cmProcess::cmProcess()
   this->ExitValue = 0;
   this->Id = 0;
   this->StartTime = 0;
+  this->ResourceUsageValid = false;
+  memset(&this->ResourceUsage, 0, sizeof(this->ResourceUsage));
 }
 
 cmProcess::~cmProcess()
@@ -175,6 +177,8 @@ int cmProcess::GetNextOutputLine(std::string& line, double timeout)
   // Record exit information.
   this->ExitValue = cmsysProcess_GetExitValue(this->Process);
   this->TotalTime = cmSystemTools::GetTime() - this->StartTime;
+  this->ResourceUsageValid =
+    cmsysProcess_GetResourceUsage(this->Process, &this->ResourceUsage) != 0;
   //  std::cerr << "Time to run: " << this->TotalTime << "\n";
   return cmsysProcess_Pipe_None;
 }
@@ -44,6 +44,11 @@ public:
   int GetExitValue() { return this->ExitValue;}
   double GetTotalTime() { return this->TotalTime;}
   int GetExitException();
+  // Resources used by the process, valid once it has finished and
+  // only if HasResourceUsage returns true.
+  bool HasResourceUsage() { return this->ResourceUsageValid;}
+  cmsysProcess_ResourceUsage const& GetResourceUsage()
+    { return this->ResourceUsage;}
   /**
    * Read one line of output but block for no more than timeout.
    * Returns:
@@ -77,6 +82,8 @@ private:
   std::string Output;
   int Id;
   int ExitValue;
+  bool ResourceUsageValid;
+  cmsysProcess_ResourceUsage ResourceUsage;
 };
 
 #endif
@@ -14,7 +14,12 @@
 #include "cmSystemTools.h"
 #include <cmsys/ios/iostream>
 #include <cmsys/Directory.hxx>
+#include <cmsys/Process.h>
 #include <cm_libarchive.h>
+#include <cm_zlib.h>
+#include <cm_bzlib.h>
+
+#include <deque>
 
 //----------------------------------------------------------------------------
 class cmArchiveWrite::Entry
@@ -26,14 +31,285 @@ public:
   operator struct archive_entry*() { return this->Object; }
 };
 
+//----------------------------------------------------------------------------
+// Collect the uncompressed archive data into blocks and compress each
+// block in a separate "cmake -E cmake_compress_block" process.  Up to
+// Jobs processes run at once and their output is appended to the stream
+// in block order.
+class cmArchiveWrite::BlockCompressor
+{
+public:
+  BlockCompressor(std::ostream& os, const char* method, unsigned int jobs,
+                  std::string const& tempDir, std::string const& cmake);
+  ~BlockCompressor();
+  bool Write(const char* data, size_t n);
+  bool Finish();
+  std::string const& GetError() const { return this->Error; }
+private:
+  struct Job
+  {
+    cmsysProcess* Process;
+    std::string Input;
+    std::string Output;
+  };
+  bool StartJob();
+  bool FinishJob();
+  std::ostream& Stream;
+  std::string Method;
+  unsigned int Jobs;
+  std::string TempDir;
+  std::string CMake;
+  std::string Block;
+  unsigned long Count;
+  std::deque<Job> Running;
+  std::string Error;
+};
+
+// Blocks are large enough that the cost of starting a process and of
+// restarting compression at each block boundary is negligible.
+static const size_t cmArchiveWriteBlockSize = 8 * 1024 * 1024;
+
+//----------------------------------------------------------------------------
+cmArchiveWrite::BlockCompressor::BlockCompressor(std::ostream& os,
+                                                 const char* method,
+                                                 unsigned int jobs,
+                                                 std::string const& tempDir,
+                                                 std::string const& cmake):
+  Stream(os), Method(method), Jobs(jobs), TempDir(tempDir), CMake(cmake),
+  Count(0)
+{
+  this->Block.reserve(cmArchiveWriteBlockSize);
+}
+
+//----------------------------------------------------------------------------
+cmArchiveWrite::BlockCompressor::~BlockCompressor()
+{
+  // Abandon jobs left running after an error.
+  for(std::deque<Job>::iterator j = this->Running.begin();
+      j != this->Running.end(); ++j)
+    {
+    cmsysProcess_Kill(j->Process);
+    cmsysProcess_Delete(j->Process);
+    cmSystemTools::RemoveFile(j->Input.c_str());
+    cmSystemTools::RemoveFile(j->Output.c_str());
+    }
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::BlockCompressor::Write(const char* data, size_t n)
+{
+  this->Block.append(data, n);
+  if(this->Block.size() >= cmArchiveWriteBlockSize)
+    {
+    return this->StartJob();
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::BlockCompressor::Finish()
+{
+  if(!this->Block.empty() && !this->StartJob())
+    {
+    return false;
+    }
+  while(!this->Running.empty())
+    {
+    if(!this->FinishJob())
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::BlockCompressor::StartJob()
+{
+  if(this->Running.size() >= this->Jobs && !this->FinishJob())
+    {
+    return false;
+    }
+
+  cmOStringStream name;
+  name << this->TempDir << "/cmArchiveBlock" << this->Count++;
+  Job job;
+  job.Input = name.str() + ".in";
+  job.Output = name.str() + ".out";
+  {
+  std::ofstream fout(job.Input.c_str(), std::ios::out | cmsys_ios_binary);
+  if(!fout.write(this->Block.data(),
+                 static_cast<cmsys_ios::streamsize>(this->Block.size())))
+    {
+    this->Error = "Error writing \"" + job.Input + "\": ";
+    this->Error += cmSystemTools::GetLastSystemError();
+    return false;
+    }
+  }
+  this->Block.clear();
+
+  const char* cmd[7];
+  cmd[0] = this->CMake.c_str();
+  cmd[1] = "-E";
+  cmd[2] = "cmake_compress_block";
+  cmd[3] = this->Method.c_str();
+  cmd[4] = job.Input.c_str();
+  cmd[5] = job.Output.c_str();
+  cmd[6] = 0;
+  job.Process = cmsysProcess_New();
+  cmsysProcess_SetCommand(job.Process, cmd);
+  cmsysProcess_SetOption(job.Process, cmsysProcess_Option_HideWindow, 1);
+  cmsysProcess_Execute(job.Process);
+  if(cmsysProcess_GetState(job.Process) != cmsysProcess_State_Executing)
+    {
+    // The job never ran, so only this block is abandoned.
+    this->Error = "Error compressing \"" + job.Input + "\"";
+    if(cmsysProcess_GetState(job.Process) == cmsysProcess_State_Error)
+      {
+      this->Error += ": ";
+      this->Error += cmsysProcess_GetErrorString(job.Process);
+      }
+    cmsysProcess_Delete(job.Process);
+    cmSystemTools::RemoveFile(job.Input.c_str());
+    return false;
+    }
+  this->Running.push_back(job);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::BlockCompressor::FinishJob()
+{
+  Job job = this->Running.front();
+  this->Running.pop_front();
+  cmsysProcess_WaitForExit(job.Process, 0);
+  bool okay =
+    cmsysProcess_GetState(job.Process) == cmsysProcess_State_Exited &&
+    cmsysProcess_GetExitValue(job.Process) == 0;
+  if(!okay)
+    {
+    this->Error = "Error compressing \"" + job.Input + "\"";
+    if(cmsysProcess_GetState(job.Process) == cmsysProcess_State_Error)
+      {
+      this->Error += ": ";
+      this->Error += cmsysProcess_GetErrorString(job.Process);
+      }
+    }
+  cmsysProcess_Delete(job.Process);
+
+  // Append the compressed block to the archive.
+  if(okay)
+    {
+    std::ifstream fin(job.Output.c_str(), std::ios::in | cmsys_ios_binary);
+    char buffer[16384];
+    while(fin)
+      {
+      fin.read(buffer, sizeof(buffer));
+      if(fin.gcount() > 0 && !this->Stream.write(buffer, fin.gcount()))
+        {
+        break;
+        }
+      }
+    if(!fin.eof() || !this->Stream)
+      {
+      this->Error = "Error copying \"" + job.Output + "\" to the archive";
+      okay = false;
+      }
+    }
+  cmSystemTools::RemoveFile(job.Input.c_str());
+  cmSystemTools::RemoveFile(job.Output.c_str());
+  return okay;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::CompressBlock(const char* method,
+                                   const char* in, const char* out)
+{
+  std::string data;
+  {
+  std::ifstream fin(in, std::ios::in | cmsys_ios_binary);
+  char buffer[16384];
+  while(fin)
+    {
+    fin.read(buffer, sizeof(buffer));
+    data.append(buffer, static_cast<size_t>(fin.gcount()));
+    }
+  if(!fin.eof())
+    {
+    return false;
+    }
+  }
+  std::ofstream fout(out, std::ios::out | cmsys_ios_binary);
+  if(!fout)
+    {
+    return false;
+    }
+
+  char buffer[65536];
+  if(strcmp(method, "gzip") == 0)
+    {
+    // A window of 15 bits plus 16 selects the gzip format.
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if(deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                    Z_DEFAULT_STRATEGY) != Z_OK)
+      {
+      return false;
+      }
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    strm.avail_in = static_cast<uInt>(data.size());
+    int ret;
+    do
+      {
+      strm.next_out = reinterpret_cast<Bytef*>(buffer);
+      strm.avail_out = sizeof(buffer);
+      ret = deflate(&strm, Z_FINISH);
+      fout.write(buffer, sizeof(buffer) - strm.avail_out);
+      } while(ret == Z_OK);
+    deflateEnd(&strm);
+    return ret == Z_STREAM_END && fout;
+    }
+  else if(strcmp(method, "bzip2") == 0)
+    {
+    bz_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if(BZ2_bzCompressInit(&strm, 9, 0, 30) != BZ_OK)
+      {
+      return false;
+      }
+    strm.next_in = const_cast<char*>(data.data());
+    strm.avail_in = static_cast<unsigned int>(data.size());
+    int ret;
+    do
+      {
+      strm.next_out = buffer;
+      strm.avail_out = sizeof(buffer);
+      ret = BZ2_bzCompress(&strm, BZ_FINISH);
+      fout.write(buffer, sizeof(buffer) - strm.avail_out);
+      } while(ret == BZ_FINISH_OK);
+    BZ2_bzCompressEnd(&strm);
+    return ret == BZ_STREAM_END && fout;
+    }
+  return false;
+}
+
 //----------------------------------------------------------------------------
 struct cmArchiveWrite::Callback
 {
   // archive_write_callback
-  static __LA_SSIZE_T Write(struct archive*, void *cd,
+  static __LA_SSIZE_T Write(struct archive* a, void *cd,
                             const void *b, size_t n)
     {
     cmArchiveWrite* self = static_cast<cmArchiveWrite*>(cd);
+    if(self->Blocks)
+      {
+      if(self->Blocks->Write(static_cast<const char*>(b), n))
+        {
+        return static_cast<__LA_SSIZE_T>(n);
+        }
+      archive_set_error(a, -1, "%s", self->Blocks->GetError().c_str());
+      return static_cast<__LA_SSIZE_T>(-1);
+      }
     if(self->Stream.write(static_cast<const char*>(b),
                           static_cast<cmsys_ios::streamsize>(n)))
       {
@@ -47,12 +323,33 @@ struct cmArchiveWrite::Callback
 };
 
 //----------------------------------------------------------------------------
-cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c, Type t):
+cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c, Type t,
+                               unsigned int jobs, const char* tempDir):
   Stream(os),
   Archive(archive_write_new()),
   Disk(archive_read_disk_new()),
-  Verbose(false)
+  Verbose(false),
+  UID(-1),
+  GID(-1),
+  Blocks(0),
+  Finished(false)
 {
+  // Compress blocks in separate processes if there is more than one
+  // job and a cmake executable to run them.  Otherwise libarchive
+  // compresses the whole archive as one stream.
+  if(jobs > 1 && tempDir && (c == CompressGZip || c == CompressBZip2))
+    {
+    std::string cmake = cmSystemTools::GetExecutableDirectory();
+    cmake += "/cmake";
+    cmake += cmSystemTools::GetExecutableExtension();
+    if(cmSystemTools::FileExists(cmake.c_str(), true))
+      {
+      this->Blocks = new BlockCompressor(
+        os, c == CompressGZip? "gzip" : "bzip2", jobs, tempDir, cmake);
+      c = CompressNone;
+      }
+    }
+
   switch (c)
     {
     case CompressNone:
@@ -154,8 +451,58 @@ cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c, Type t):
 //----------------------------------------------------------------------------
 cmArchiveWrite::~cmArchiveWrite()
 {
+  if(!this->Finished && this->Okay() && !this->Finish())
+    {
+    cmSystemTools::Error(this->Error.c_str());
+    }
   archive_read_finish(this->Disk);
   archive_write_finish(this->Archive);
+  delete this->Blocks;
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::Finish()
+{
+  if(this->Finished)
+    {
+    return this->Okay();
+    }
+  this->Finished = true;
+  if(!this->Okay())
+    {
+    return false;
+    }
+  if(archive_write_close(this->Archive) != ARCHIVE_OK)
+    {
+    const char* err = archive_error_string(this->Archive);
+    this->Error = "archive_write_close: ";
+    this->Error += err? err : "unknown error";
+    return false;
+    }
+  if(this->Blocks && !this->Blocks->Finish())
+    {
+    this->Error = this->Blocks->GetError();
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void cmArchiveWrite::SetOwner(int uid, int gid,
+                              const char* uname, const char* gname)
+{
+  this->UID = uid;
+  this->GID = gid;
+  this->UName = uname? uname : "";
+  this->GName = gname? gname : "";
+}
+
+//----------------------------------------------------------------------------
+bool cmArchiveWrite::SetFileHash(const char* algo)
+{
+  this->Hash = cmCryptoHash::New(algo);
+  this->FileHashes.clear();
+  return this->Hash.get() != 0;
 }
 
 //----------------------------------------------------------------------------
@@ -240,6 +587,13 @@ bool cmArchiveWrite::AddFile(const char* file,
   // Clear acl and xattr fields not useful for distribution.
   archive_entry_acl_clear(e);
   archive_entry_xattr_clear(e);
+  if(this->UID >= 0)
+    {
+    archive_entry_set_uid(e, this->UID);
+    archive_entry_set_gid(e, this->GID);
+    archive_entry_copy_uname(e, this->UName.c_str());
+    archive_entry_copy_gname(e, this->GName.c_str());
+    }
   if(archive_write_header(this->Archive, e) != ARCHIVE_OK)
     {
     this->Error = "archive_write_header: ";
@@ -255,6 +609,11 @@ bool cmArchiveWrite::AddFile(const char* file,
       {
       return this->AddData(file, size);
       }
+    else if(this->Hash.get() && archive_entry_filetype(e) == AE_IFREG)
+      {
+      this->Hash->Initialize();
+      this->FileHashes[file] = this->Hash->Finalize();
+      }
     }
   return true;
 }
@@ -272,6 +631,11 @@ bool cmArchiveWrite::AddData(const char* file, size_t size)
     return false;
     }
 
+  if(this->Hash.get())
+    {
+    this->Hash->Initialize();
+    }
+
   char buffer[16384];
   size_t nleft = size;
   while(nleft > 0)
@@ -293,6 +657,11 @@ bool cmArchiveWrite::AddData(const char* file, size_t size)
       this->Error += archive_error_string(this->Archive);
       return false;
       }
+    if(this->Hash.get())
+      {
+      this->Hash->Append(reinterpret_cast<unsigned char const*>(buffer),
+                         static_cast<int>(nnext));
+      }
     nleft -= nnext;
     }
   if(nleft > 0)
@@ -303,5 +672,9 @@ bool cmArchiveWrite::AddData(const char* file, size_t size)
     this->Error += cmSystemTools::GetLastSystemError();
     return false;
     }
+  if(this->Hash.get())
+    {
+    this->FileHashes[file] = this->Hash->Finalize();
+    }
   return true;
 }
@@ -13,6 +13,7 @@
 #define cmArchiveWrite_h
 
 #include "cmStandardIncludes.h"
+#include "cmCryptoHash.h"
 
 #if !defined(CMAKE_BUILD_WITH_CMAKE)
 # error "cmArchiveWrite not allowed during bootstrap build!"
@@ -45,8 +46,15 @@ public:
     TypeZIP
   };
 
-  /** Construct with output stream to which to write archive.  */
-  cmArchiveWrite(std::ostream& os, Compress c = CompressNone, Type = TypeTAR);
+  /**
+   * Construct with output stream to which to write archive.  With more
+   * than one job a gzip or bzip2 archive is compressed in blocks by up
+   * to that many processes at once, using files in the given temporary
+   * directory.  Each block is a separate compressed stream and standard
+   * tools decode the concatenated streams as one.
+   */
+  cmArchiveWrite(std::ostream& os, Compress c = CompressNone, Type = TypeTAR,
+                 unsigned int jobs = 1, const char* tempDir = 0);
   ~cmArchiveWrite();
 
   /**
@@ -59,6 +67,14 @@ public:
    */
   bool Add(std::string path, size_t skip = 0, const char* prefix = 0);
 
+  /**
+   * Write the end of the archive and, when compressing in blocks, wait
+   * for the last blocks to be written.  Returns false on error.  The
+   * destructor calls this if it was not called, but then an error can
+   * no longer be seen by the caller.
+   */
+  bool Finish();
+
   /** Returns true if there has been no error.  */
   operator safe_bool() const
     { return this->Okay()? &cmArchiveWrite::safe_bool_true : 0; }
@@ -73,6 +89,28 @@ public:
   // std::cout.
   void SetVerbose(bool v) { this->Verbose = v; }
 
+  /** Record the given owner for all entries added instead of the owner
+      of the files on disk.  */
+  void SetOwner(int uid, int gid, const char* uname, const char* gname);
+
+  /**
+   * Compute a hash of the content of each regular file with the given
+   * algorithm while it is added, so that the file is read only once.
+   * The hashes are available from GetFileHashes keyed by the path of
+   * each file on disk.  Returns false if the algorithm is unknown.
+   */
+  bool SetFileHash(const char* algo);
+  std::map<cmStdString, std::string> const& GetFileHashes() const
+    { return this->FileHashes; }
+
+  /**
+   * Compress the file "in" into the file "out" as one complete gzip or
+   * bzip2 stream.  This is run by "cmake -E cmake_compress_block" for
+   * each block of an archive compressed by several jobs.
+   */
+  static bool CompressBlock(const char* method,
+                            const char* in, const char* out);
+
 private:
   bool Okay() const { return this->Error.empty(); }
   bool AddPath(const char* path, size_t skip, const char* prefix);
@@ -83,12 +121,21 @@ private:
   friend struct Callback;
 
   class Entry;
+  class BlockCompressor;
 
   std::ostream& Stream;
   struct archive* Archive;
   struct archive* Disk;
   bool Verbose;
   std::string Error;
+  int UID;
+  int GID;
+  std::string UName;
+  std::string GName;
+  cmsys::auto_ptr<cmCryptoHash> Hash;
+  std::map<cmStdString, std::string> FileHashes;
+  BlockCompressor* Blocks;
+  bool Finished;
 };
 
 #endif
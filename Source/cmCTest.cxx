@@ -2151,6 +2151,27 @@ void cmCTest::HandleCommandLineArguments(size_t &i,
     this->GetHandler("memcheck")->
       SetPersistentOption("TestsToRunInformation",args[i].c_str());
     }
+  if(this->CheckArgument(arg, "--shard") && i < args.size() - 1)
+    {
+    i++;
+    this->GetHandler("test")->SetPersistentOption("ShardInformation",
+                                                  args[i].c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("ShardInformation", args[i].c_str());
+    }
+  if(this->CheckArgument(arg, "--shard-cost-data") && i < args.size() - 1)
+    {
+    i++;
+    this->GetHandler("test")->SetPersistentOption("ShardCostData",
+                                                  args[i].c_str());
+    this->GetHandler("memcheck")->
+      SetPersistentOption("ShardCostData", args[i].c_str());
+    }
+  if(this->CheckArgument(arg, "--fail-on-performance-regression"))
+    {
+    this->GetHandler("test")->
+      SetPersistentOption("FailOnPerformanceRegression", "true");
+    }
   if(this->CheckArgument(arg, "-U", "--union"))
     {
     this->GetHandler("test")->SetPersistentOption("UseUnion", "true");
@@ -2247,6 +2268,7 @@ int cmCTest::Run(std::vector<std::string> &args, std::string* output)
   bool cmakeAndTest = false;
   bool performSomeTest = true;
   bool SRArgumentSpecified = false;
+  std::vector<std::string> mergeResults;
 
   // copy the command line
   for(size_t i=0; i < args.size(); ++i)
@@ -2351,6 +2373,12 @@ int cmCTest::Run(std::vector<std::string> &args, std::string* output)
       cmakeAndTest = true;
       }
 
+    if(this->CheckArgument(arg, "--merge-results") && i < args.size() - 1)
+      {
+      i++;
+      mergeResults.push_back(args[i]);
+      }
+
     if(this->CheckArgument(arg, "--schedule-random"))
       {
       this->ScheduleType = "Random";
@@ -2394,6 +2422,14 @@ int cmCTest::Run(std::vector<std::string> &args, std::string* output)
     return retv;
     }
 
+  // combine the results of tests run in shards
+  if(!mergeResults.empty())
+    {
+    cmCTestTestHandler* handler =
+      static_cast<cmCTestTestHandler*>(this->GetHandler("test"));
+    return handler->MergeResults(mergeResults);
+    }
+
   // if some tests must be run 
   if(performSomeTest)
     {
@@ -23,7 +23,8 @@ public:
   static cmsys::auto_ptr<cmCryptoHash> New(const char* algo);
   std::string HashString(const char* input);
   std::string HashFile(const char* file);
-protected:
+
+  /** Compute a hash incrementally from data given in pieces.  */
   virtual void Initialize()=0;
   virtual void Append(unsigned char const*, int)=0;
   virtual std::string Finalize()=0;
@@ -11,6 +11,8 @@
 ============================================================================*/
 #include "cmDefinitions.h"
 
+#include "cmSystemTools.h"
+
 //----------------------------------------------------------------------------
 cmDefinitions::Def cmDefinitions::NoDef;
 
@@ -84,6 +86,65 @@ const char* cmDefinitions::Set(const char* key, const char* value)
   return def.Exists? def.c_str() : 0;
 }
 
+//----------------------------------------------------------------------------
+std::vector<std::string> const*
+cmDefinitions::GetList(const char* key, bool* hasEmpty)
+{
+  Def const& def = this->GetInternal(key);
+  if(!def.Exists)
+    {
+    return 0;
+    }
+  if(!def.List)
+    {
+    def.List = new DefList;
+    def.List->HasEmpty = false;
+    if(!def.empty())
+      {
+      cmSystemTools::ExpandListArgument(def, def.List->Elements, true);
+      }
+    for(std::vector<std::string>::const_iterator i =
+          def.List->Elements.begin(); i != def.List->Elements.end(); ++i)
+      {
+      if(i->empty())
+        {
+        def.List->HasEmpty = true;
+        break;
+        }
+      }
+    }
+  if(hasEmpty)
+    {
+    *hasEmpty = def.List->HasEmpty;
+    }
+  return &def.List->Elements;
+}
+
+//----------------------------------------------------------------------------
+const char* cmDefinitions::Append(const char* key,
+                                  std::vector<std::string> const& values)
+{
+  // Make sure the value is stored in this scope.
+  if(!this->GetInternal(key).Exists)
+    {
+    return 0;
+    }
+  Def& def = this->Map.find(key)->second;
+
+  // Extend the value in place to avoid copying it.
+  for(std::vector<std::string>::const_iterator i = values.begin();
+      i != values.end(); ++i)
+    {
+    if(!def.empty())
+      {
+      def += ";";
+      }
+    def += *i;
+    }
+  def.ClearList();
+  return def.c_str();
+}
+
 //----------------------------------------------------------------------------
 std::set<cmStdString> cmDefinitions::LocalKeys() const
 {
@@ -40,6 +40,19 @@ public:
   /** Set (or unset if null) a value associated with a key.  */
   const char* Set(const char* key, const char* value);
 
+  /** Get the value associated with a key split into a list with
+      empty elements preserved; null if none.  The list is computed on
+      first use and kept until the value changes.  If given, hasEmpty
+      is set to whether any element is empty.  */
+  std::vector<std::string> const* GetList(const char* key,
+                                          bool* hasEmpty = 0);
+
+  /** Append elements to the list value associated with a key.  The
+      key must already have a value.  Returns the new value, or null if
+      the key has no value.  */
+  const char* Append(const char* key,
+                     std::vector<std::string> const& values);
+
   /** Get the set of all local keys.  */
   std::set<cmStdString> LocalKeys() const;
 
@@ -51,13 +64,31 @@ public:
   std::set<cmStdString> ClosureKeys() const;
 
 private:
-  // String with existence boolean.
+  // List form of a value.
+  struct DefList
+  {
+    std::vector<std::string> Elements;
+    bool HasEmpty;
+  };
+
+  // String with existence boolean and cached list form.  The list
+  // form is not copied with the value.
   struct Def: public cmStdString
   {
-    Def(): cmStdString(), Exists(false) {}
-    Def(const char* v): cmStdString(v?v:""), Exists(v?true:false) {}
-    Def(Def const& d): cmStdString(d), Exists(d.Exists) {}
+    Def(): cmStdString(), Exists(false), List(0) {}
+    Def(const char* v): cmStdString(v?v:""), Exists(v?true:false), List(0) {}
+    Def(Def const& d): cmStdString(d), Exists(d.Exists), List(0) {}
+    ~Def() { delete this->List; }
+    Def& operator=(Def const& d)
+      {
+      this->cmStdString::operator=(d);
+      this->Exists = d.Exists;
+      this->ClearList();
+      return *this;
+      }
+    void ClearList() { delete this->List; this->List = 0; }
     bool Exists;
+    mutable DefList* List;
   };
   static Def NoDef;
 
@@ -520,6 +520,17 @@ void cmDocumentVariables::DefineVariables(cmake* cm)
      false,
      "Variables That Change Behavior");
 
+    cm->DefineProperty
+    ("CMAKE_AUTOMOC_JOBS",  cmProperty::VARIABLE,
+     "Maximum number of moc processes automoc runs at the same time.",
+     "By default automoc runs moc on one file after the other.  "
+     "When set to a number greater than one, automoc starts up to that "
+     "many moc processes at once.  "
+     "The value is read when the AUTOMOC property of a target is processed "
+     "at generate time.",
+     false,
+     "Variables That Change Behavior");
+
     cm->DefineProperty
     ("CMAKE_FIND_LIBRARY_PREFIXES",  cmProperty::VARIABLE,
      "Prefixes to prepend when looking for libraries.",
@@ -599,6 +610,21 @@ void cmDocumentVariables::DefineVariables(cmake* cm)
      ,false,
      "Variables That Change Behavior");
 
+  cm->DefineProperty
+    ("CMAKE_SKIP_UNCHANGED_REGENERATION", cmProperty::VARIABLE,
+     "Do not regenerate Makefiles when inputs are touched but not changed.",
+     "The Makefile generators rerun CMake when any CMake input file, such "
+     "as a CMakeLists.txt file or CMakeCache.txt, is newer than the "
+     "generated build system.  "
+     "If CMAKE_SKIP_UNCHANGED_REGENERATION is set to TRUE, the MD5 hash of "
+     "each input file is recorded at generate time and CMake is rerun only "
+     "if the content of a newer input file has changed.  "
+     "Note that this means touching a CMakeLists.txt file no longer forces "
+     "CMake to rerun, for example to pick up new files matched by "
+     "file(GLOB)."
+     ,false,
+     "Variables That Change Behavior");
+
   cm->DefineProperty
     ("CMAKE_MODULE_PATH", cmProperty::VARIABLE,
      "List of directories to search for CMake modules.",
@@ -24,6 +24,13 @@
 # include <sys/link.h> // For dynamic section information
 #endif
 
+// Map files into memory instead of reading them through a stream.
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 //----------------------------------------------------------------------------
 // Low-level byte swapping implementation.
 template <size_t s> struct cmELFByteSwapSize {};
@@ -57,6 +64,86 @@ void cmELFByteSwap(T& x)
   cmELFByteSwap(reinterpret_cast<char*>(&x), cmELFByteSwapSize<sizeof(T)>());
 }
 
+//----------------------------------------------------------------------------
+// Input stream buffer over a read-only memory mapping of a whole file.
+// The parser seeks to many small structures, and each seek on an
+// ifstream discards its buffer and reads the file again.
+class cmELFMappedBuffer: public std::streambuf
+{
+public:
+  cmELFMappedBuffer(char* data, size_t size): Data(data), Size(size)
+    {
+    this->setg(data, data, data + size);
+    }
+  ~cmELFMappedBuffer()
+    {
+    munmap(this->Data, this->Size);
+    }
+protected:
+  virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                           std::ios_base::openmode)
+    {
+    off_type pos = off;
+    if(dir == std::ios_base::cur)
+      {
+      pos += this->gptr() - this->eback();
+      }
+    else if(dir == std::ios_base::end)
+      {
+      pos += static_cast<off_type>(this->Size);
+      }
+    if(pos < 0 || pos > static_cast<off_type>(this->Size))
+      {
+      return pos_type(off_type(-1));
+      }
+    this->setg(this->eback(), this->eback() + pos, this->egptr());
+    return pos_type(pos);
+    }
+  virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which)
+    {
+    return this->seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+private:
+  char* Data;
+  size_t Size;
+};
+
+// Input stream owning a cmELFMappedBuffer.
+class cmELFMappedStream: public std::istream
+{
+public:
+  cmELFMappedStream(char* data, size_t size):
+    std::istream(0), Buffer(data, size)
+    {
+    this->rdbuf(&this->Buffer);
+    }
+private:
+  cmELFMappedBuffer Buffer;
+};
+
+// Open a file for parsing.  Map it into memory when possible and fall
+// back to a file stream otherwise.
+static std::istream* cmELFOpen(const char* fname)
+{
+  int fd = open(fname, O_RDONLY);
+  if(fd >= 0)
+    {
+    struct stat st;
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+      {
+      size_t size = static_cast<size_t>(st.st_size);
+      void* data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(data != MAP_FAILED)
+        {
+        close(fd);
+        return new cmELFMappedStream(static_cast<char*>(data), size);
+        }
+      }
+    close(fd);
+    }
+  return new std::ifstream(fname);
+}
+
 //----------------------------------------------------------------------------
 class cmELFInternal
 {
@@ -66,7 +153,7 @@ public:
 
   // Construct and take ownership of the file stream object.
   cmELFInternal(cmELF* external,
-                cmsys::auto_ptr<std::ifstream>& fin,
+                cmsys::auto_ptr<std::istream>& fin,
                 ByteOrderType order):
     External(external),
     Stream(*fin.release()),
@@ -199,7 +286,7 @@ public:
 
   // Construct with a stream and byte swap indicator.
   cmELFInternalImpl(cmELF* external,
-                    cmsys::auto_ptr<std::ifstream>& fin,
+                    cmsys::auto_ptr<std::istream>& fin,
                     ByteOrderType order);
 
   // Return the number of sections as specified by the ELF header.
@@ -457,7 +544,7 @@ private:
 template <class Types>
 cmELFInternalImpl<Types>
 ::cmELFInternalImpl(cmELF* external,
-                    cmsys::auto_ptr<std::ifstream>& fin,
+                    cmsys::auto_ptr<std::istream>& fin,
                     ByteOrderType order):
   cmELFInternal(external, fin, order)
 {
@@ -702,7 +789,7 @@ cmELFInternalImpl<Types>::GetDynamicSectionString(int tag)
 cmELF::cmELF(const char* fname): Internal(0)
 {
   // Try to open the file.
-  cmsys::auto_ptr<std::ifstream> fin(new std::ifstream(fname));
+  cmsys::auto_ptr<std::istream> fin(cmELFOpen(fname));
 
   // Quit now if the file could not be opened.
   if(!fin.get() || !*fin)
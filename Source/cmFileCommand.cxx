@@ -14,6 +14,7 @@
 #include "cmHexFileConverter.h"
 #include "cmFileTimeComparison.h"
 #include "cmCryptoHash.h"
+#include "cmLocalGenerator.h"
 
 #if defined(CMAKE_BUILD_WITH_CMAKE)
 #include "cm_curl.h"
@@ -27,6 +28,22 @@
 #include <cmsys/Directory.hxx>
 #include <cmsys/Glob.hxx>
 #include <cmsys/RegularExpression.hxx>
+#include <cmsys/Process.h>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+# include <process.h>
+#else
+# include <unistd.h>
+#endif
+#if defined(__linux__)
+# include <fcntl.h>
+# include <sys/ioctl.h>
+# include <sys/sendfile.h>
+# include <sys/syscall.h>
+# if !defined(FICLONE)
+#  define FICLONE _IOW(0x94, 9, int)
+# endif
+#endif
 
 // Table of permissions flags.
 #if defined(_WIN32) && !defined(__CYGWIN__)
@@ -940,6 +957,168 @@ cmFileCommand::HandleDifferentCommand(std::vector<std::string> const& args)
   return true;
 }
 
+//----------------------------------------------------------------------------
+#if defined(__linux__)
+// Copy the rest of "in" to "out" with copy_file_range or sendfile.
+static bool cmFileCopierKernelCopyData(int in, int out, off_t size,
+                                       bool range)
+{
+  while(size > 0)
+    {
+    ssize_t n;
+    if(range)
+      {
+# if defined(__NR_copy_file_range)
+      n = syscall(__NR_copy_file_range, in, static_cast<loff_t*>(0),
+                  out, static_cast<loff_t*>(0),
+                  static_cast<size_t>(size), 0u);
+# else
+      n = -1;
+# endif
+      }
+    else
+      {
+      n = sendfile(out, in, 0, static_cast<size_t>(size));
+      }
+    if(n <= 0)
+      {
+      return false;
+      }
+    size -= n;
+    }
+  return true;
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Copy a file letting the kernel move the data.  The destination
+// shares the source's blocks on file systems supporting reflinks and
+// is otherwise written with copy_file_range or sendfile.  Returns
+// false if none of these is available so the caller can fall back to
+// copying through user space.
+static bool cmFileCopierKernelCopy(const char* fromFile, const char* toFile)
+{
+#if defined(__linux__)
+  int in = open(fromFile, O_RDONLY);
+  if(in < 0)
+    {
+    return false;
+    }
+  struct stat from;
+  struct stat to;
+  if(fstat(in, &from) != 0 || !S_ISREG(from.st_mode) || from.st_size == 0)
+    {
+    close(in);
+    return false;
+    }
+  if(stat(toFile, &to) == 0 &&
+     to.st_dev == from.st_dev && to.st_ino == from.st_ino)
+    {
+    // Same file, nothing to copy.
+    close(in);
+    return true;
+    }
+
+  // Replace the destination so that read-only files can be written.
+  unlink(toFile);
+  int out = open(toFile, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if(out < 0)
+    {
+    close(in);
+    return false;
+    }
+  bool done = ioctl(out, FICLONE, in) == 0;
+  for(int method = 0; !done && method < 2; ++method)
+    {
+    // Start over after a method that failed part way.
+    if(lseek(in, 0, SEEK_SET) != 0 || ftruncate(out, 0) != 0 ||
+       lseek(out, 0, SEEK_SET) != 0)
+      {
+      break;
+      }
+    done = cmFileCopierKernelCopyData(in, out, from.st_size, method == 0);
+    }
+  if(done)
+    {
+    done = fchmod(out, from.st_mode & 07777) == 0;
+    }
+  close(in);
+  if(close(out) != 0)
+    {
+    done = false;
+    }
+  return done;
+#else
+  (void)fromFile;
+  (void)toFile;
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Replace a file by a hard link to another.
+static bool cmFileCopierHardLink(const char* fromFile, const char* toFile)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  (void)fromFile;
+  (void)toFile;
+  return false;
+#else
+  unlink(toFile);
+  return link(fromFile, toFile) == 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Name a permission mask with the keywords file(INSTALL) accepts.
+// Returns false if the mask has bits no keyword names, such as the
+// sticky bit.
+static bool cmFileCopierPermissionKeywords(mode_t permissions,
+                                           std::string& result)
+{
+  struct { mode_t Mode; const char* Name; } const keywords[] =
+    {
+      {mode_owner_read, "OWNER_READ"},
+      {mode_owner_write, "OWNER_WRITE"},
+      {mode_owner_execute, "OWNER_EXECUTE"},
+      {mode_group_read, "GROUP_READ"},
+      {mode_group_write, "GROUP_WRITE"},
+      {mode_group_execute, "GROUP_EXECUTE"},
+      {mode_world_read, "WORLD_READ"},
+      {mode_world_write, "WORLD_WRITE"},
+      {mode_world_execute, "WORLD_EXECUTE"},
+      {mode_setuid, "SETUID"},
+      {mode_setgid, "SETGID"}
+    };
+  mode_t named = 0;
+  for(unsigned int i = 0; i < sizeof(keywords)/sizeof(keywords[0]); ++i)
+    {
+    if(keywords[i].Mode && (permissions & keywords[i].Mode))
+      {
+      result += " ";
+      result += keywords[i].Name;
+      }
+    named |= keywords[i].Mode;
+    }
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  // Only the bits with keywords have a meaning here.
+  (void)named;
+  return true;
+#else
+  return (permissions & 07777 & ~named) == 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+static int cmFileCopierGetPid()
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  return _getpid();
+#else
+  return static_cast<int>(getpid());
+#endif
+}
+
 //----------------------------------------------------------------------------
 // File installation helper class.
 struct cmFileCopier
@@ -949,6 +1128,9 @@ struct cmFileCopier
     Makefile(command->GetMakefile()),
     Name(name),
     Always(false),
+    CompareContent(false),
+    HardLink(false),
+    Jobs(1),
     MatchlessFiles(true),
     FilePermissions(0),
     DirPermissions(0),
@@ -968,8 +1150,27 @@ protected:
   cmMakefile* Makefile;
   const char* Name;
   bool Always;
+  bool CompareContent;
   cmFileTimeComparison FileTimes;
 
+  // Whether to hard link files that need no permission changes
+  // instead of copying them.
+  bool HardLink;
+
+  // Number of processes copying files at the same time.  With more
+  // than one, files to be copied are queued while the rest of the
+  // installation is done, and copied at the end of Run.
+  unsigned int Jobs;
+  struct PendingFile
+  {
+    std::string From;
+    std::string To;
+    mode_t Permissions;
+  };
+  std::vector<PendingFile> PendingFiles;
+  std::vector<std::pair<std::string, mode_t> > PendingDirPermissions;
+  bool InstallPendingFiles();
+
   // Whether to install a file not matching any expression.
   bool MatchlessFiles;
 
@@ -1064,6 +1265,8 @@ protected:
   bool InstallSymlink(const char* fromFile, const char* toFile);
   bool InstallFile(const char* fromFile, const char* toFile,
                    MatchProperties const& match_properties);
+  bool InstallFileData(const char* fromFile, const char* toFile,
+                       bool copy, bool touch, mode_t permissions);
   bool InstallDirectory(const char* source, const char* destination,
                         MatchProperties const& match_properties);
   virtual bool Install(const char* fromFile, const char* toFile);
@@ -1442,7 +1645,7 @@ bool cmFileCopier::Run(std::vector<std::string> const& args)
       return false;
       }
     }
-  return true;
+  return this->InstallPendingFiles();
 }
 
 //----------------------------------------------------------------------------
@@ -1465,7 +1668,10 @@ bool cmFileCopier::Install(const char* fromFile, const char* toFile)
     return true;
     }
 
-  if(cmSystemTools::SameFile(fromFile, toFile))
+  // A destination hard linked to the source is handled by InstallFile.
+  if(cmSystemTools::SameFile(fromFile, toFile) &&
+     cmSystemTools::GetRealPath(fromFile) ==
+     cmSystemTools::GetRealPath(toFile))
     {
     return true;
     }
@@ -1541,6 +1747,7 @@ bool cmFileCopier::InstallFile(const char* fromFile, const char* toFile,
 {
   // Determine whether we will copy the file.
   bool copy = true;
+  bool touch = false;
   if(!this->Always)
     {
     // If both files exist with the same time do not copy.
@@ -1548,13 +1755,88 @@ bool cmFileCopier::InstallFile(const char* fromFile, const char* toFile,
       {
       copy = false;
       }
+    // If both files have the same content only the time is updated.
+    else if(this->CompareContent &&
+            cmSystemTools::FileExists(toFile) &&
+            !cmSystemTools::FilesDiffer(fromFile, toFile))
+      {
+      copy = false;
+      touch = true;
+      }
+    }
+
+  // Determine the permissions of the destination file.
+  mode_t permissions = (match_properties.Permissions?
+                        match_properties.Permissions : this->FilePermissions);
+  mode_t fromPermissions = 0;
+  bool haveFromPermissions = false;
+  bool linked = cmSystemTools::SameFile(fromFile, toFile);
+  if(!permissions || (copy && this->HardLink) || linked)
+    {
+    haveFromPermissions =
+      cmSystemTools::GetPermissions(fromFile, fromPermissions);
+    }
+  if(!permissions)
+    {
+    // No permissions were explicitly provided but the user requested
+    // that the source file permissions be used.
+    permissions = fromPermissions;
+    }
+
+  // A destination hard linked to the source shares its permissions and
+  // time, so these must not be updated through it.  Keep the link if
+  // nothing would change and otherwise replace it by a copy.
+  if(linked)
+    {
+    if(haveFromPermissions &&
+       (permissions & 07777) == (fromPermissions & 07777))
+      {
+      this->ReportCopy(toFile, TypeFile, false);
+      return true;
+      }
+    cmSystemTools::RemoveFile(toFile);
+    copy = true;
+    touch = false;
     }
 
   // Inform the user about this file installation.
   this->ReportCopy(toFile, TypeFile, copy);
 
+  // A hard link shares the permissions and time of the source, so it
+  // may be used only if these would not be changed.
+  if(copy && this->HardLink && haveFromPermissions &&
+     (permissions & 07777) == (fromPermissions & 07777) &&
+     cmFileCopierHardLink(fromFile, toFile))
+    {
+    return true;
+    }
+
+  // Queue the copy for a worker process if the name is kept and the
+  // worker can be given the exact permissions.
+  std::string keywords;
+  if(copy && this->Jobs > 1 &&
+     cmSystemTools::GetFilenameName(fromFile) ==
+     cmSystemTools::GetFilenameName(toFile) &&
+     cmFileCopierPermissionKeywords(permissions, keywords))
+    {
+    PendingFile pf;
+    pf.From = fromFile;
+    pf.To = toFile;
+    pf.Permissions = permissions;
+    this->PendingFiles.push_back(pf);
+    return true;
+    }
+
+  return this->InstallFileData(fromFile, toFile, copy, touch, permissions);
+}
+
+//----------------------------------------------------------------------------
+bool cmFileCopier::InstallFileData(const char* fromFile, const char* toFile,
+                                   bool copy, bool touch, mode_t permissions)
+{
   // Copy the file.
-  if(copy && !cmSystemTools::CopyAFile(fromFile, toFile, true))
+  if(copy && !cmFileCopierKernelCopy(fromFile, toFile) &&
+     !cmSystemTools::CopyAFile(fromFile, toFile, true))
     {
     cmOStringStream e;
     e << this->Name << " cannot copy file \"" << fromFile
@@ -1564,7 +1846,7 @@ bool cmFileCopier::InstallFile(const char* fromFile, const char* toFile,
     }
 
   // Set the file modification time of the destination file.
-  if(copy && !this->Always)
+  if((copy || touch) && !this->Always)
     {
     // Add write permission so we can set the file time.
     // Permissions are set unconditionally below anyway.
@@ -1584,14 +1866,6 @@ bool cmFileCopier::InstallFile(const char* fromFile, const char* toFile,
     }
 
   // Set permissions of the destination file.
-  mode_t permissions = (match_properties.Permissions?
-                        match_properties.Permissions : this->FilePermissions);
-  if(!permissions)
-    {
-    // No permissions were explicitly provided but the user requested
-    // that the source file permissions be used.
-    cmSystemTools::GetPermissions(fromFile, permissions);
-    }
   return this->SetPermissions(toFile, permissions);
 }
 
@@ -1674,10 +1948,159 @@ bool cmFileCopier::InstallDirectory(const char* source,
       }
     }
 
-  // Set the requested permissions of the destination directory.
+  // Set the requested permissions of the destination directory.  If
+  // files are queued they may still need to be written into it.
+  if(this->Jobs > 1 && permissions_after)
+    {
+    this->PendingDirPermissions.push_back(
+      std::make_pair(std::string(destination), permissions_after));
+    return true;
+    }
   return this->SetPermissions(destination, permissions_after);
 }
 
+//----------------------------------------------------------------------------
+bool cmFileCopier::InstallPendingFiles()
+{
+  std::vector<PendingFile> const& files = this->PendingFiles;
+
+  // Each worker process is a "cmake -P" running file(INSTALL) on a
+  // contiguous slice of the queue.  Starting one costs about as much as
+  // copying a few dozen small files, so give each at least that many.
+  size_t jobs = this->Jobs;
+  if(files.size() / 16 < jobs)
+    {
+    jobs = files.size() / 16;
+    }
+  const char* cmake = this->Makefile->GetDefinition("CMAKE_COMMAND");
+  std::string dir = this->Makefile->GetCurrentOutputDirectory();
+  dir += "/CMakeFiles";
+  cmOStringStream base;
+  base << dir << "/CMakeInstallJob" << cmFileCopierGetPid() << "-";
+
+  // Write the worker scripts.  If this is not possible copy in process.
+  std::vector<std::string> scripts;
+  for(size_t job = 0; jobs > 1 && cmake && job < jobs; ++job)
+    {
+    cmOStringStream script;
+    script << base.str() << job << ".cmake";
+    std::ofstream fout(script.str().c_str());
+    if(!fout)
+      {
+      scripts.clear();
+      break;
+      }
+    scripts.push_back(script.str());
+
+    // The destinations already include DESTDIR and installing in the
+    // worker must not queue again.
+    fout << "set(ENV{DESTDIR} \"\")\n"
+         << "set(ENV{CMAKE_INSTALL_JOBS} \"\")\n"
+         << "set(ENV{CMAKE_INSTALL_MODE} \"\")\n";
+    cmLocalGenerator* lg = this->Makefile->GetLocalGenerator();
+    std::string lastDir;
+    mode_t lastPermissions = 0;
+    size_t end = files.size() * (job + 1) / jobs;
+    for(size_t i = files.size() * job / jobs; i < end; ++i)
+      {
+      // Files with the same destination and permissions share a call.
+      std::string toDir = cmSystemTools::GetFilenamePath(files[i].To);
+      if(i == files.size() * job / jobs || toDir != lastDir ||
+         files[i].Permissions != lastPermissions)
+        {
+        if(!lastDir.empty())
+          {
+          fout << ")\n";
+          }
+        fout << "file(INSTALL DESTINATION "
+             << lg->EscapeForCMake(toDir.c_str()) << " TYPE FILE";
+        std::string keywords;
+        if(files[i].Permissions &&
+           cmFileCopierPermissionKeywords(files[i].Permissions, keywords))
+          {
+          fout << " PERMISSIONS" << keywords;
+          }
+        else
+          {
+          fout << " USE_SOURCE_PERMISSIONS";
+          }
+        fout << " FILES";
+        lastDir = toDir;
+        lastPermissions = files[i].Permissions;
+        }
+      fout << "\n  " << lg->EscapeForCMake(files[i].From.c_str());
+      }
+    fout << ")\n";
+    }
+
+  bool result = true;
+  if(scripts.empty())
+    {
+    for(std::vector<PendingFile>::const_iterator i = files.begin();
+        result && i != files.end(); ++i)
+      {
+      result = this->InstallFileData(i->From.c_str(), i->To.c_str(),
+                                     true, false, i->Permissions);
+      }
+    }
+  else
+    {
+    // Run all workers at once and wait for them in order.
+    std::vector<cmsysProcess*> workers;
+    for(std::vector<std::string>::const_iterator si = scripts.begin();
+        si != scripts.end(); ++si)
+      {
+      std::string out = *si + ".out";
+      std::string err = *si + ".err";
+      const char* cmd[] = {cmake, "-P", si->c_str(), 0};
+      cmsysProcess* cp = cmsysProcess_New();
+      cmsysProcess_SetCommand(cp, cmd);
+      cmsysProcess_SetOption(cp, cmsysProcess_Option_HideWindow, 1);
+      cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDOUT, out.c_str());
+      cmsysProcess_SetPipeFile(cp, cmsysProcess_Pipe_STDERR, err.c_str());
+      cmsysProcess_Execute(cp);
+      workers.push_back(cp);
+      }
+    for(size_t w = 0; w < workers.size(); ++w)
+      {
+      cmsysProcess* cp = workers[w];
+      cmsysProcess_WaitForExit(cp, 0);
+      std::string out = scripts[w] + ".out";
+      std::string err = scripts[w] + ".err";
+      if(result &&
+         (cmsysProcess_GetState(cp) != cmsysProcess_State_Exited ||
+          cmsysProcess_GetExitValue(cp) != 0))
+        {
+        cmOStringStream e;
+        e << this->Name << " failed to copy files in a worker process:\n";
+        std::ifstream fin(err.c_str());
+        std::string line;
+        while(cmSystemTools::GetLineFromStream(fin, line))
+          {
+          e << line << "\n";
+          }
+        this->FileCommand->SetError(e.str().c_str());
+        result = false;
+        }
+      cmsysProcess_Delete(cp);
+      cmSystemTools::RemoveFile(scripts[w].c_str());
+      cmSystemTools::RemoveFile(out.c_str());
+      cmSystemTools::RemoveFile(err.c_str());
+      }
+    }
+  this->PendingFiles.clear();
+
+  // Set the final permissions of directories, innermost first.
+  for(std::vector<std::pair<std::string, mode_t> >::const_iterator
+        di = this->PendingDirPermissions.begin();
+      result && di != this->PendingDirPermissions.end(); ++di)
+    {
+    result = this->SetPermissions(di->first.c_str(), di->second);
+    }
+  this->PendingDirPermissions.clear();
+  return result;
+}
+
 //----------------------------------------------------------------------------
 bool cmFileCommand::HandleCopyCommand(std::vector<std::string> const& args)
 {
@@ -1699,6 +2122,17 @@ struct cmFileInstaller: public cmFileCopier
     // Check whether to copy files always or only if they have changed.
     this->Always =
       cmSystemTools::IsOn(cmSystemTools::GetEnv("CMAKE_INSTALL_ALWAYS"));
+    this->CompareContent = cmSystemTools::IsOn(
+      cmSystemTools::GetEnv("CMAKE_INSTALL_COMPARE_CONTENT"));
+    // Check whether to hard link files into a staging tree.
+    const char* mode = cmSystemTools::GetEnv("CMAKE_INSTALL_MODE");
+    this->HardLink = mode && strcmp(mode, "HARDLINK") == 0;
+    // Check how many processes may copy files at once.
+    const char* jobs = cmSystemTools::GetEnv("CMAKE_INSTALL_JOBS");
+    if(jobs && atoi(jobs) > 1)
+      {
+      this->Jobs = static_cast<unsigned int>(atoi(jobs));
+      }
     // Get the current manifest.
     this->Manifest =
       this->Makefile->GetSafeDefinition("CMAKE_INSTALL_MANIFEST_FILES");
@@ -1816,6 +2250,15 @@ bool cmFileInstaller::Parse(std::vector<std::string> const& args)
     return false;
     }
 
+  // Targets are patched after installation, e.g. by RPATH_CHANGE, so
+  // their files must not share data with the build tree.
+  if(this->InstallType != cmTarget::INSTALL_FILES &&
+     this->InstallType != cmTarget::INSTALL_PROGRAMS &&
+     this->InstallType != cmTarget::INSTALL_DIRECTORY)
+    {
+    this->HardLink = false;
+    }
+
   return true;
 }
 
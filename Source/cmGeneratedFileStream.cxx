@@ -13,9 +13,144 @@
 
 #include "cmSystemTools.h"
 
+#include <time.h>
+
 #if defined(CMAKE_BUILD_WITH_CMAKE)
 # include <cm_zlib.h>
+# include <cmsys/MD5.h>
+#endif
+
+//----------------------------------------------------------------------------
+// Table of content hashes of generated files.  An entry is trusted
+// only while the destination file still has the recorded modification
+// time and length, and only if that time was older than the time the
+// entry was recorded.
+struct cmGeneratedFileStreamHash
+{
+  std::string Hash;
+  long MTime;
+  long CheckTime;
+  unsigned long Length;
+  bool Used;
+};
+struct cmGeneratedFileStreamHashTable
+{
+  cmGeneratedFileStreamHashTable(): Enabled(false) {}
+  bool Enabled;
+  std::string File;
+  std::map<cmStdString, cmGeneratedFileStreamHash> Hashes;
+};
+static cmGeneratedFileStreamHashTable cmGeneratedFileStreamHashes;
+static const char cmGeneratedFileStreamHashesHeader[] =
+  "# Hashes of generated file content, version 2.";
+
+//----------------------------------------------------------------------------
+// Stream buffer that hashes content on its way to the real file buffer.
+// It also collects output into large blocks before writing.
+class cmGeneratedFileStreamBuffer: public std::streambuf
+{
+public:
+  cmGeneratedFileStreamBuffer(std::streambuf* target);
+  ~cmGeneratedFileStreamBuffer();
+
+  // Flush buffered content and return the hash of all content
+  // written, or an empty string if writing failed.
+  std::string Finalize();
+protected:
+  virtual int_type overflow(int_type c);
+  virtual int sync();
+private:
+  bool FlushBuffer();
+  std::streambuf* Target;
+  std::vector<char> Buffer;
+  bool Failed;
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  cmsysMD5* MD5;
+#endif
+};
+
+//----------------------------------------------------------------------------
+cmGeneratedFileStreamBuffer
+::cmGeneratedFileStreamBuffer(std::streambuf* target):
+  Target(target), Buffer(64*1024), Failed(false)
+{
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  this->MD5 = cmsysMD5_New();
+  cmsysMD5_Initialize(this->MD5);
+#endif
+  this->setp(&this->Buffer[0], &this->Buffer[0] + this->Buffer.size());
+}
+
+//----------------------------------------------------------------------------
+cmGeneratedFileStreamBuffer::~cmGeneratedFileStreamBuffer()
+{
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  cmsysMD5_Delete(this->MD5);
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool cmGeneratedFileStreamBuffer::FlushBuffer()
+{
+  std::streamsize n = this->pptr() - this->pbase();
+  if(n > 0 && !this->Failed)
+    {
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+    cmsysMD5_Append(this->MD5,
+                    reinterpret_cast<unsigned char const*>(this->pbase()),
+                    static_cast<int>(n));
+#endif
+    if(this->Target->sputn(this->pbase(), n) != n)
+      {
+      this->Failed = true;
+      }
+    }
+  this->setp(&this->Buffer[0], &this->Buffer[0] + this->Buffer.size());
+  return !this->Failed;
+}
+
+//----------------------------------------------------------------------------
+cmGeneratedFileStreamBuffer::int_type
+cmGeneratedFileStreamBuffer::overflow(int_type c)
+{
+  if(!this->FlushBuffer())
+    {
+    return traits_type::eof();
+    }
+  if(!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+    *this->pptr() = traits_type::to_char_type(c);
+    this->pbump(1);
+    return c;
+    }
+  return traits_type::not_eof(c);
+}
+
+//----------------------------------------------------------------------------
+int cmGeneratedFileStreamBuffer::sync()
+{
+  if(!this->FlushBuffer() || this->Target->pubsync() != 0)
+    {
+    return -1;
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+std::string cmGeneratedFileStreamBuffer::Finalize()
+{
+  if(this->sync() != 0)
+    {
+    return "";
+    }
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  char md5out[32];
+  cmsysMD5_FinalizeHex(this->MD5, md5out);
+  return std::string(md5out, 32);
+#else
+  return "";
 #endif
+}
 
 //----------------------------------------------------------------------------
 cmGeneratedFileStream::cmGeneratedFileStream():
@@ -35,6 +170,7 @@ cmGeneratedFileStream::cmGeneratedFileStream(const char* name, bool quiet):
                          this->TempName.c_str());
     cmSystemTools::ReportLastSystemError("");
     }
+  this->InstallHashBuffer();
 }
 
 //----------------------------------------------------------------------------
@@ -45,6 +181,7 @@ cmGeneratedFileStream::~cmGeneratedFileStream()
   // stream will be destroyed which will close the temporary file.
   // Finally the base destructor will be called to replace the
   // destination file.
+  this->FinishHashBuffer();
   this->Okay = (*this)?true:false;
 }
 
@@ -73,6 +210,7 @@ cmGeneratedFileStream::Open(const char* name, bool quiet, bool binaryFlag)
                          this->TempName.c_str());
     cmSystemTools::ReportLastSystemError("");
     }
+  this->InstallHashBuffer();
   return *this;
 }
 
@@ -81,6 +219,7 @@ bool
 cmGeneratedFileStream::Close()
 {
   // Save whether the temporary output file is valid before closing.
+  this->FinishHashBuffer();
   this->Okay = (*this)?true:false;
 
   // Close the temporary output file.
@@ -90,6 +229,40 @@ cmGeneratedFileStream::Close()
   return this->cmGeneratedFileStreamBase::Close();
 }
 
+//----------------------------------------------------------------------------
+void cmGeneratedFileStream::InstallHashBuffer()
+{
+  // Hash the content only while the hash table is enabled, and never
+  // for a stream that failed to open.
+  delete this->HashBuffer;
+  this->HashBuffer = 0;
+  this->ContentHash = "";
+  if(cmGeneratedFileStreamHashes.Enabled && *this)
+    {
+    this->HashBuffer = new cmGeneratedFileStreamBuffer(this->Stream::rdbuf());
+    this->std::ios::rdbuf(this->HashBuffer);
+    }
+}
+
+//----------------------------------------------------------------------------
+void cmGeneratedFileStream::FinishHashBuffer()
+{
+  if(!this->HashBuffer || this->std::ios::rdbuf() != this->HashBuffer)
+    {
+    return;
+    }
+  this->ContentHash = this->HashBuffer->Finalize();
+  bool okay = (*this && !this->ContentHash.empty());
+
+  // Write directly to the file buffer from now on.
+  this->std::ios::rdbuf(this->Stream::rdbuf());
+  if(!okay)
+    {
+    this->ContentHash = "";
+    this->setstate(std::ios::badbit);
+    }
+}
+
 //----------------------------------------------------------------------------
 void cmGeneratedFileStream::SetCopyIfDifferent(bool copy_if_different)
 {
@@ -115,7 +288,8 @@ cmGeneratedFileStreamBase::cmGeneratedFileStreamBase():
   CopyIfDifferent(false),
   Okay(false),
   Compress(false),
-  CompressExtraExtension(true)
+  CompressExtraExtension(true),
+  HashBuffer(0)
 {
 }
 
@@ -126,7 +300,8 @@ cmGeneratedFileStreamBase::cmGeneratedFileStreamBase(const char* name):
   CopyIfDifferent(false),
   Okay(false),
   Compress(false),
-  CompressExtraExtension(true)
+  CompressExtraExtension(true),
+  HashBuffer(0)
 {
   this->Open(name);
 }
@@ -135,6 +310,7 @@ cmGeneratedFileStreamBase::cmGeneratedFileStreamBase(const char* name):
 cmGeneratedFileStreamBase::~cmGeneratedFileStreamBase()
 {
   this->Close();
+  delete this->HashBuffer;
 }
 
 //----------------------------------------------------------------------------
@@ -174,7 +350,8 @@ bool cmGeneratedFileStreamBase::Close()
   if(!this->Name.empty() &&
     this->Okay &&
     (!this->CopyIfDifferent ||
-     cmSystemTools::FilesDiffer(this->TempName.c_str(), resname.c_str())))
+     (!this->ContentHashMatches() &&
+      cmSystemTools::FilesDiffer(this->TempName.c_str(), resname.c_str()))))
     {
     // The destination is to be replaced.  Rename the temporary to the
     // destination atomically.
@@ -197,12 +374,62 @@ bool cmGeneratedFileStreamBase::Close()
 
   // Else, the destination was not replaced.
   //
+  // Either way the destination now has the content we hashed.
+  if(!this->Name.empty() && this->Okay && this->CopyIfDifferent)
+    {
+    this->StoreContentHash(resname.c_str());
+    }
+  this->ContentHash = "";
+
   // Always delete the temporary file. We never want it to stay around.
   cmSystemTools::RemoveFile(this->TempName.c_str());
 
   return replaced;
 }
 
+//----------------------------------------------------------------------------
+bool cmGeneratedFileStreamBase::ContentHashMatches()
+{
+  if(this->ContentHash.empty() || this->Compress)
+    {
+    return false;
+    }
+  std::map<cmStdString, cmGeneratedFileStreamHash>::const_iterator i =
+    cmGeneratedFileStreamHashes.Hashes.find(this->Name);
+  if(i == cmGeneratedFileStreamHashes.Hashes.end() ||
+     i->second.Hash != this->ContentHash)
+    {
+    return false;
+    }
+
+  // The recorded hash is valid only if the destination has not been
+  // modified since it was recorded.  A modification in the same second
+  // as the recording would keep the time, so then compare the content.
+  return (i->second.MTime < i->second.CheckTime &&
+          cmSystemTools::FileExists(this->Name.c_str()) &&
+          cmSystemTools::ModifiedTime(this->Name.c_str()) ==
+          i->second.MTime &&
+          cmSystemTools::FileLength(this->Name.c_str()) ==
+          i->second.Length);
+}
+
+//----------------------------------------------------------------------------
+void cmGeneratedFileStreamBase::StoreContentHash(const char* resname)
+{
+  if(this->ContentHash.empty() || this->Compress ||
+     !cmGeneratedFileStreamHashes.Enabled)
+    {
+    return;
+    }
+  cmGeneratedFileStreamHash& h =
+    cmGeneratedFileStreamHashes.Hashes[resname];
+  h.Hash = this->ContentHash;
+  h.MTime = cmSystemTools::ModifiedTime(resname);
+  h.CheckTime = static_cast<long>(time(0));
+  h.Length = cmSystemTools::FileLength(resname);
+  h.Used = true;
+}
+
 //----------------------------------------------------------------------------
 #ifdef CMAKE_BUILD_WITH_CMAKE
 int cmGeneratedFileStreamBase::CompressFile(const char* oldname,
@@ -258,3 +485,89 @@ void cmGeneratedFileStream::SetName(const char* fname)
     }
   this->Name = fname;
 }
+
+//----------------------------------------------------------------------------
+bool cmGeneratedFileStream::EnableContentHashes(const char* file)
+{
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  cmGeneratedFileStreamHashTable& table = cmGeneratedFileStreamHashes;
+  if(table.Enabled)
+    {
+    return false;
+    }
+  table.Enabled = true;
+  table.File = file;
+  table.Hashes.clear();
+
+  // Line format is a 32-byte hex string, the modification time, the
+  // time the hash was recorded, the length, and the file name (with no
+  // escaping) separated by spaces.  Tables written in another format
+  // are ignored.
+  std::ifstream fin(file, std::ios::in | cmsys_ios_binary);
+  std::string line;
+  if(!cmSystemTools::GetLineFromStream(fin, line) ||
+     line != cmGeneratedFileStreamHashesHeader)
+    {
+    return true;
+    }
+  while(fin && cmSystemTools::GetLineFromStream(fin, line))
+    {
+    if(line.size() < 34 || line[0] == '#')
+      {
+      continue;
+      }
+    cmGeneratedFileStreamHash h;
+    h.Hash = line.substr(0, 32);
+    h.Used = false;
+    char const* p = line.c_str() + 33;
+    char* end;
+    h.MTime = strtol(p, &end, 10);
+    if(end == p || *end != ' ')
+      {
+      continue;
+      }
+    p = end + 1;
+    h.CheckTime = strtol(p, &end, 10);
+    if(end == p || *end != ' ')
+      {
+      continue;
+      }
+    p = end + 1;
+    h.Length = strtoul(p, &end, 10);
+    if(end == p || *end != ' ')
+      {
+      continue;
+      }
+    table.Hashes[end + 1] = h;
+    }
+  return true;
+#else
+  (void)file;
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void cmGeneratedFileStream::DisableContentHashes()
+{
+  cmGeneratedFileStreamHashTable& table = cmGeneratedFileStreamHashes;
+  if(!table.Enabled)
+    {
+    return;
+    }
+  table.Enabled = false;
+
+  // Save only the files generated since the table was enabled.
+  cmGeneratedFileStream fout(table.File.c_str());
+  fout << cmGeneratedFileStreamHashesHeader << "\n";
+  for(std::map<cmStdString, cmGeneratedFileStreamHash>::const_iterator
+        i = table.Hashes.begin(); i != table.Hashes.end(); ++i)
+    {
+    if(i->second.Used)
+      {
+      fout << i->second.Hash << " " << i->second.MTime << " "
+           << i->second.CheckTime << " " << i->second.Length << " " << i->first << "\n";
+      }
+    }
+  table.Hashes.clear();
+}
@@ -18,6 +18,8 @@
 # pragma set woff 1375 /* base class destructor not virtual */
 #endif
 
+class cmGeneratedFileStreamBuffer;
+
 // This is the first base class of cmGeneratedFileStream.  It will be
 // created before and destroyed after the ofstream portion and can
 // therefore be used to manage the temporary file.
@@ -64,6 +66,18 @@ protected:
 
   // Whether the destionation file is compressed
   bool CompressExtraExtension;
+
+  // Buffer that hashes the content while it is written, if any.
+  cmGeneratedFileStreamBuffer* HashBuffer;
+
+  // The content hash of the temporary file, if it was computed.
+  std::string ContentHash;
+
+  // Whether the destination is known to match the content hash.
+  bool ContentHashMatches();
+
+  // Record the content hash for the destination after it is written.
+  void StoreContentHash(const char* resname);
 };
 
 /** \class cmGeneratedFileStream
@@ -141,7 +155,26 @@ public:
    */
   void SetName(const char* fname);
 
+  /**
+   * Enable the table of content hashes of generated files persisted in
+   * the given file.  While enabled, content written to copy-if-different
+   * streams is hashed as it is written and compared against the table
+   * so that unchanged destination files need not be read back.  Returns
+   * false if the table is already enabled, in which case the caller
+   * must not disable it.
+   */
+  static bool EnableContentHashes(const char* file);
+
+  /**
+   * Save the content hashes recorded since the table was enabled and
+   * disable the table.
+   */
+  static void DisableContentHashes();
+
 private:
+  void InstallHashBuffer();
+  void FinishHashBuffer();
+
   cmGeneratedFileStream(cmGeneratedFileStream const&); // not implemented
 };
 
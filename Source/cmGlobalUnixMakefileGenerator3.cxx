@@ -303,6 +303,26 @@ void cmGlobalUnixMakefileGenerator3::WriteMainCMakefile()
   cmakefileStream
     << "  )\n\n";
 
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  // Optionally save the content hash of each dependency so that the
+  // check-build-system step can skip regeneration when a dependency
+  // is newer than the build system but its content has not changed.
+  if(lg->GetMakefile()->IsOn("CMAKE_SKIP_UNCHANGED_REGENERATION"))
+    {
+    cmakefileStream
+      << "# The MD5 hashes of the above files, in the same order:\n"
+      << "SET(CMAKE_MAKEFILE_DEPENDS_MD5\n";
+    this->WriteDependHash(cmakefileStream, cache.c_str());
+    for(std::vector<std::string>::const_iterator i = lfiles.begin();
+        i !=  lfiles.end(); ++i)
+      {
+      this->WriteDependHash(cmakefileStream, i->c_str());
+      }
+    cmakefileStream
+      << "  )\n\n";
+    }
+#endif
+
   // Build the path to the cache check file.
   std::string check = this->GetCMakeInstance()->GetHomeOutputDirectory();
   check += cmake::GetCMakeFilesDirectory();
@@ -355,6 +375,21 @@ void cmGlobalUnixMakefileGenerator3::WriteMainCMakefile()
                                         this->LocalGenerators);
 }
 
+//----------------------------------------------------------------------------
+void cmGlobalUnixMakefileGenerator3::WriteDependHash(std::ostream& os,
+                                                     const char* file)
+{
+  // A dependency that cannot be hashed gets an empty entry so that
+  // the check-build-system step reruns CMake when it is newer.
+  char md5[33];
+  md5[32] = 0;
+  if(!cmSystemTools::ComputeFileMD5(file, md5))
+    {
+    md5[0] = 0;
+    }
+  os << "  \"" << md5 << "\"\n";
+}
+
 void cmGlobalUnixMakefileGenerator3
 ::WriteMainCMakefileLanguageRules(cmGeneratedFileStream& cmakefileStream,
                                   std::vector<cmLocalGenerator *> &lGenerators
@@ -119,6 +119,7 @@ public:
 protected:
   void WriteMainMakefile2();
   void WriteMainCMakefile();
+  void WriteDependHash(std::ostream& os, const char* file);
 
   void WriteConvenienceRules2(std::ostream& ruleFileStream,
                               cmLocalUnixMakefileGenerator3*);
@@ -612,7 +612,7 @@ namespace
         const char* rex = (argP2)->c_str();
         cmStringCommand::ClearMatches(makefile);
         cmsys::RegularExpression regEntry;
-        if ( !regEntry.compile(rex) )
+        if ( !cmStringCommand::CompileRegex(rex, regEntry) )
           {
           cmOStringStream error;
           error << "Regular expression \"" << rex << "\" cannot compile";
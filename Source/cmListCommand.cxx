@@ -73,52 +73,66 @@ bool cmListCommand
 }
 
 //----------------------------------------------------------------------------
-bool cmListCommand::GetListString(std::string& listString, const char* var)
+bool cmListCommand::GetList(std::vector<std::string>& list, const char* var)
 {
-  if ( !var )
+  std::vector<std::string> storage;
+  std::vector<std::string> const* view = 0;
+  bool result = this->GetListView(view, storage, var);
+  if(view == &storage)
     {
-    return false;
+    list.swap(storage);
     }
-  // get the old value
-  const char* cacheValue
-    = this->Makefile->GetDefinition(var);
-  if(!cacheValue)
+  else
     {
-    return false;
+    list = *view;
     }
-  listString = cacheValue;
-  return true;
+  return result;
 }
 
 //----------------------------------------------------------------------------
-bool cmListCommand::GetList(std::vector<std::string>& list, const char* var)
+bool cmListCommand::GetListView(std::vector<std::string> const*& list,
+                                std::vector<std::string>& storage,
+                                const char* var)
 {
-  std::string listString;
-  if ( !this->GetListString(listString, var) )
+  list = &storage;
+  if ( !var )
+    {
+    return false;
+    }
+  // get the old value and its cached list form, if any
+  std::vector<std::string> const* cached = 0;
+  bool hasEmpty = false;
+  const char* listString =
+    this->Makefile->GetListDefinition(var, cached, hasEmpty);
+  if(!listString)
     {
     return false;
     }
   // if the size of the list 
-  if(listString.size() == 0)
+  if(!*listString)
     {
     return true;
     }
   // expand the variable into a list
-  cmSystemTools::ExpandListArgument(listString, list, true);
-  // check the list for empty values
-  bool hasEmpty = false;
-  for(std::vector<std::string>::iterator i = list.begin(); 
-      i != list.end(); ++i)
+  if(!cached)
     {
-    if(i->size() == 0)
+    cmSystemTools::ExpandListArgument(listString, storage, true);
+    // check the list for empty values
+    for(std::vector<std::string>::iterator i = storage.begin(); 
+        i != storage.end(); ++i)
       {
-      hasEmpty = true;
-      break;
+      if(i->size() == 0)
+        {
+        hasEmpty = true;
+        break;
+        }
       }
+    cached = &storage;
     }
   // if no empty elements then just return 
   if(!hasEmpty)
     {
+    list = cached;
     return true;
     }
   // if we have empty elements we need to check policy CMP0007
@@ -130,8 +144,8 @@ bool cmListCommand::GetList(std::vector<std::string>& list, const char* var)
       // OLD behavior is to allow compatibility, so recall
       // ExpandListArgument without the true which will remove
       // empty values
-      list.clear();
-      cmSystemTools::ExpandListArgument(listString, list);
+      storage.clear();
+      cmSystemTools::ExpandListArgument(listString, storage);
       std::string warn = this->Makefile->GetPolicies()->
         GetPolicyWarning(cmPolicies::CMP0007);
       warn += " List has value = [";
@@ -145,10 +159,11 @@ bool cmListCommand::GetList(std::vector<std::string>& list, const char* var)
       // OLD behavior is to allow compatibility, so recall
       // ExpandListArgument without the true which will remove
       // empty values
-      list.clear();
-      cmSystemTools::ExpandListArgument(listString, list);
+      storage.clear();
+      cmSystemTools::ExpandListArgument(listString, storage);
       return true;
     case cmPolicies::NEW:
+      list = cached;
       return true;
     case cmPolicies::REQUIRED_IF_USED:
     case cmPolicies::REQUIRED_ALWAYS:
@@ -173,12 +188,13 @@ bool cmListCommand::HandleLengthCommand(std::vector<std::string> const& args)
 
   const std::string& listName = args[1];
   const std::string& variableName = args[args.size() - 1];
-  std::vector<std::string> varArgsExpanded;
+  std::vector<std::string> storage;
+  std::vector<std::string> const* varArgsExpanded = 0;
   // do not check the return value here
   // if the list var is not found varArgsExpanded will have size 0
   // and we will return 0
-  this->GetList(varArgsExpanded, listName.c_str());
-  size_t length = varArgsExpanded.size();
+  this->GetListView(varArgsExpanded, storage, listName.c_str());
+  size_t length = varArgsExpanded->size();
   char buffer[1024];
   sprintf(buffer, "%d", static_cast<int>(length));
 
@@ -198,12 +214,14 @@ bool cmListCommand::HandleGetCommand(std::vector<std::string> const& args)
   const std::string& listName = args[1];
   const std::string& variableName = args[args.size() - 1];
   // expand the variable
-  std::vector<std::string> varArgsExpanded;
-  if ( !this->GetList(varArgsExpanded, listName.c_str()) )
+  std::vector<std::string> storage;
+  std::vector<std::string> const* listView = 0;
+  if ( !this->GetListView(listView, storage, listName.c_str()) )
     {
     this->Makefile->AddDefinition(variableName.c_str(), "NOTFOUND");
     return true;
     }
+  std::vector<std::string> const& varArgsExpanded = *listView;
 
   std::string value;
   size_t cc;
@@ -250,20 +268,9 @@ bool cmListCommand::HandleAppendCommand(std::vector<std::string> const& args)
     }
 
   const std::string& listName = args[1];
-  // expand the variable
-  std::string listString;
-  this->GetListString(listString, listName.c_str());
-  size_t cc;
-  for ( cc = 2; cc < args.size(); ++ cc )
-    {
-    if(listString.size())
-      {
-      listString += ";";
-      }
-    listString += args[cc];
-    }
-
-  this->Makefile->AddDefinition(listName.c_str(), listString.c_str());
+  // append to the variable in place
+  std::vector<std::string> values(args.begin() + 2, args.end());
+  this->Makefile->AppendListDefinition(listName.c_str(), values);
   return true;
 }
 
@@ -279,16 +286,17 @@ bool cmListCommand::HandleFindCommand(std::vector<std::string> const& args)
   const std::string& listName = args[1];
   const std::string& variableName = args[args.size() - 1];
   // expand the variable
-  std::vector<std::string> varArgsExpanded;
-  if ( !this->GetList(varArgsExpanded, listName.c_str()) )
+  std::vector<std::string> storage;
+  std::vector<std::string> const* varArgsExpanded = 0;
+  if ( !this->GetListView(varArgsExpanded, storage, listName.c_str()) )
     {
     this->Makefile->AddDefinition(variableName.c_str(), "-1");
     return true;
     }
 
-  std::vector<std::string>::iterator it;
+  std::vector<std::string>::const_iterator it;
   unsigned int index = 0;
-  for ( it = varArgsExpanded.begin(); it != varArgsExpanded.end(); ++ it )
+  for ( it = varArgsExpanded->begin(); it != varArgsExpanded->end(); ++ it )
     {
     if ( *it == args[2] )
       {
@@ -121,7 +121,8 @@ protected:
 
 
   bool GetList(std::vector<std::string>& list, const char* var);
-  bool GetListString(std::string& listString, const char* var);
+  bool GetListView(std::vector<std::string> const*& list,
+                   std::vector<std::string>& storage, const char* var);
 };
 
 
@@ -1691,6 +1691,46 @@ void cmMakefile::AddDefinition(const char* name, const char* value)
 #endif
 }
 
+//----------------------------------------------------------------------------
+void cmMakefile::AppendListDefinition(const char* name,
+                                      std::vector<std::string> const& values)
+{
+  // Read the old value, which may come from the cache.
+  const char* old = this->GetDefinition(name);
+  cmDefinitions& defs = this->Internal->VarStack.top();
+  if(!defs.Get(name))
+    {
+    defs.Set(name, old? old : "");
+    }
+  const char* value = defs.Append(name, values);
+
+#ifdef CMAKE_STRICT
+  if (this->GetCMakeInstance())
+    {
+    this->GetCMakeInstance()->
+      RecordPropertyAccess(name,cmProperty::VARIABLE);
+    }
+#endif
+
+  if (this->Internal->VarUsageStack.size() &&
+      this->VariableInitialized(name))
+    {
+    this->CheckForUnused("changing definition", name);
+    this->Internal->VarUsageStack.top().erase(name);
+    }
+  this->Internal->VarInitStack.top().insert(name);
+
+#ifdef CMAKE_BUILD_WITH_CMAKE
+  cmVariableWatch* vv = this->GetVariableWatch();
+  if ( vv )
+    {
+    vv->VariableAccessed(name,
+                         cmVariableWatch::VARIABLE_MODIFIED_ACCESS,
+                         value,
+                         this);
+    }
+#endif
+}
 
 void cmMakefile::AddCacheDefinition(const char* name, const char* value,
                                     const char* doc,
@@ -2266,6 +2306,22 @@ const char* cmMakefile::GetDefinition(const char* name) const
   return def;
 }
 
+//----------------------------------------------------------------------------
+const char*
+cmMakefile::GetListDefinition(const char* name,
+                              std::vector<std::string> const*& list,
+                              bool& hasEmpty) const
+{
+  list = 0;
+  hasEmpty = false;
+  const char* def = this->GetDefinition(name);
+  if(def)
+    {
+    list = this->Internal->VarStack.top().GetList(name, &hasEmpty);
+    }
+  return def;
+}
+
 const char* cmMakefile::GetSafeDefinition(const char* def) const
 {
   const char* ret = this->GetDefinition(def);
@@ -2375,6 +2431,14 @@ const char *cmMakefile::ExpandVariablesInString(std::string& source,
     return source.c_str();
     }
 
+  // Most arguments only reference plain variables.  Expand them
+  // directly unless warnings about uninitialized variables are needed.
+  if(!this->GetCMakeInstance()->GetWarnUninitialized() &&
+     this->ExpandSimpleVariablesInString(source, escapeQuotes, line))
+    {
+    return source.c_str();
+    }
+
   // This method replaces ${VAR} and @VAR@ where VAR is looked up
   // with GetDefinition(), if not found in the map, nothing is expanded.
   // It also supports the $ENV{VAR} syntax where VAR is looked up in
@@ -2446,6 +2510,85 @@ const char *cmMakefile::ExpandVariablesInString(std::string& source,
   return source.c_str();
 }
 
+//----------------------------------------------------------------------------
+static bool cmMakefileIsVariableNameChar(char c)
+{
+  // Same as the variable name characters in cmCommandArgumentLexer.
+  return ((c >= 'A' && c <= 'Z') ||
+          (c >= 'a' && c <= 'z') ||
+          (c >= '0' && c <= '9') ||
+          c == '/' || c == '_' || c == '.' || c == '+' || c == '-');
+}
+
+//----------------------------------------------------------------------------
+bool cmMakefile::ExpandSimpleVariablesInString(std::string& source,
+                                               bool escapeQuotes,
+                                               long line)
+{
+  // Check that the string has no syntax other than ${VAR} so that the
+  // result is the same as that of the full parser.
+  std::string::size_type const n = source.size();
+  for(std::string::size_type i = 0; i < n; ++i)
+    {
+    char c = source[i];
+    if(c == '$')
+      {
+      if(i+1 >= n || source[i+1] != '{')
+        {
+        return false;
+        }
+      std::string::size_type j = i+2;
+      while(j < n && cmMakefileIsVariableNameChar(source[j]))
+        {
+        ++j;
+        }
+      if(j == i+2 || j >= n || source[j] != '}')
+        {
+        return false;
+        }
+      i = j;
+      }
+    else if(c == '@' || c == '\\' || c == '{' || c == '}')
+      {
+      return false;
+      }
+    }
+
+  // Replace each reference with its value.
+  std::string result;
+  result.reserve(n);
+  std::string var;
+  std::string::size_type last = 0;
+  std::string::size_type pos;
+  while((pos = source.find("${", last)) != source.npos)
+    {
+    result.append(source, last, pos-last);
+    std::string::size_type end = source.find('}', pos);
+    var.assign(source, pos+2, end-pos-2);
+    if(line >= 0 && var == "CMAKE_CURRENT_LIST_LINE")
+      {
+      cmOStringStream ostr;
+      ostr << line;
+      result += ostr.str();
+      }
+    else if(const char* value = this->GetDefinition(var.c_str()))
+      {
+      if(escapeQuotes)
+        {
+        result += cmSystemTools::EscapeQuotes(value);
+        }
+      else
+        {
+        result += value;
+        }
+      }
+    last = end+1;
+    }
+  result.append(source, last, source.npos);
+  source.swap(result);
+  return true;
+}
+
 void cmMakefile::RemoveVariablesInString(std::string& source,
                                          bool atOnly) const
 {
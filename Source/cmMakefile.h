@@ -299,6 +299,14 @@ public:
    */
   void AddDefinition(const char* name, bool);
 
+  /**
+   * Append elements to the list value of a variable.  This is
+   * equivalent to setting the variable to its old value with each
+   * element appended after a semicolon, but does not copy the value.
+   */
+  void AppendListDefinition(const char* name,
+                            std::vector<std::string> const& values);
+
   /**
    * Remove a variable definition from the build.  This is not valid
    * for cache entries, and will only affect the current makefile.
@@ -592,6 +600,17 @@ public:
   const char* GetDefinition(const char*) const;
   const char* GetSafeDefinition(const char*) const;
   const char* GetRequiredDefinition(const char* name) const;
+
+  /**
+   * Given a variable name, return its value as GetDefinition does.
+   * If the value is that of a variable in this makefile instance,
+   * also return the value split into a list with empty elements
+   * preserved, otherwise set list to null.  The list remains valid
+   * until the variable is changed.
+   */
+  const char* GetListDefinition(const char* name,
+                                std::vector<std::string> const*& list,
+                                bool& hasEmpty) const;
   bool IsDefinitionSet(const char*) const;
   /**
    * Get the list of all variables in the current space. If argument
@@ -923,6 +942,12 @@ private:
 
   bool ParseDefineFlag(std::string const& definition, bool remove);
 
+  // Expand a string whose only special syntax is ${VAR} references
+  // without running the full argument parser.  Returns false without
+  // modifying the string if it needs the full parser.
+  bool ExpandSimpleVariablesInString(std::string& source, bool escapeQuotes,
+                                     long line);
+
   bool EnforceUniqueDir(const char* srcPath, const char* binPath);
 
   void ReadSources(std::ifstream& fin, bool t);
@@ -18,12 +18,20 @@
 #include "cmSystemTools.h"
 
 #include <cmsys/Terminal.h>
+#include <cmsys/Process.h>
 
 #include <string.h>
+#include <stdio.h>
+#include <time.h>
 
 #include "cmQtAutomoc.h"
 
 
+static const char* mocIncludePattern =
+              "[\n][ \t]*#[ \t]*include[ \t]+"
+              "[\"<](([^ \">]+/)?moc_[^ \">/]+\\.cpp|[^ \">]+\\.moc)[\">]";
+
+
 static bool containsQ_OBJECT(const std::string& text)
 {
   // this simple check is much much faster than the regexp
@@ -86,6 +94,8 @@ cmQtAutomoc::cmQtAutomoc()
 ,ColorOutput(true)
 ,RunMocFailed(false)
 ,GenerateAll(false)
+,MocJobsMax(1)
+,RunStartTime(0)
 {
 
   std::string colorEnv = "";
@@ -210,6 +220,8 @@ void cmQtAutomoc::SetupAutomocTarget(cmTarget* target)
   makefile->AddDefinition("_moc_files", _moc_files.c_str());
   makefile->AddDefinition("_moc_headers", _moc_headers.c_str());
   makefile->AddDefinition("_moc_relaxed_mode", relaxedMode ? "TRUE" : "FALSE");
+  makefile->AddDefinition("_moc_jobs",
+                          makefile->GetSafeDefinition("CMAKE_AUTOMOC_JOBS"));
 
   const char* cmakeRoot = makefile->GetSafeDefinition("CMAKE_ROOT");
   std::string inputFile = cmakeRoot;
@@ -238,8 +250,10 @@ bool cmQtAutomoc::Run(const char* targetDirectory)
   cmGlobalGenerator* gg = this->CreateGlobalGenerator(&cm, targetDirectory);
   cmMakefile* makefile = gg->GetCurrentLocalGenerator()->GetMakefile();
 
+  this->RunStartTime = static_cast<long>(time(0));
   this->ReadAutomocInfoFile(makefile, targetDirectory);
   this->ReadOldMocDefinitionsFile(makefile, targetDirectory);
+  this->ReadScanCacheFile(targetDirectory);
 
   this->Init();
 
@@ -249,6 +263,7 @@ bool cmQtAutomoc::Run(const char* targetDirectory)
     }
 
   this->WriteOldMocDefinitionsFile(targetDirectory);
+  this->WriteScanCacheFile(targetDirectory);
 
   delete gg;
   gg = NULL;
@@ -311,6 +326,9 @@ bool cmQtAutomoc::ReadAutomocInfoFile(cmMakefile* makefile,
 
   this->RelaxedMode = makefile->IsOn("AM_RELAXED_MODE");
 
+  int mocJobs = atoi(makefile->GetSafeDefinition("AM_MOC_JOBS"));
+  this->MocJobsMax = mocJobs > 1 ? static_cast<unsigned int>(mocJobs) : 1;
+
   return true;
 }
 
@@ -347,6 +365,75 @@ void cmQtAutomoc::WriteOldMocDefinitionsFile(const char* targetDirectory)
 }
 
 
+void cmQtAutomoc::ReadScanCacheFile(const char* targetDirectory)
+{
+  std::string filename(cmSystemTools::CollapseFullPath(targetDirectory));
+  cmSystemTools::ConvertToUnixSlashes(filename);
+  filename += "/AutomocScanCache.txt";
+
+  // Each entry is a line "<mtime> <size> <Q_OBJECT> <count> <file>"
+  // followed by <count> lines naming the moc files the file includes.
+  std::ifstream fin(filename.c_str());
+  std::string line;
+  while (cmSystemTools::GetLineFromStream(fin, line))
+    {
+    long mtime = 0;
+    unsigned long size = 0;
+    int qObject = 0;
+    unsigned int count = 0;
+    int pathStart = 0;
+    if (sscanf(line.c_str(), "%ld %lu %d %u %n",
+               &mtime, &size, &qObject, &count, &pathStart) < 4
+        || pathStart == 0)
+      {
+      break;
+      }
+    ScanInfo& info = this->OldScanInfos[line.substr(pathStart)];
+    info.MTime = mtime;
+    info.Size = size;
+    info.ContainsQ_OBJECT = qObject != 0;
+    for (unsigned int i = 0;
+         i < count && cmSystemTools::GetLineFromStream(fin, line); ++i)
+      {
+      info.MocIncludes.push_back(line);
+      }
+    }
+}
+
+
+void cmQtAutomoc::WriteScanCacheFile(const char* targetDirectory)
+{
+  std::string filename(cmSystemTools::CollapseFullPath(targetDirectory));
+  cmSystemTools::ConvertToUnixSlashes(filename);
+  filename += "/AutomocScanCache.txt";
+
+  std::fstream outfile;
+  outfile.open(filename.c_str(),
+               std::ios::out | std::ios::trunc);
+  for (std::map<std::string, ScanInfo>::const_iterator
+         it = this->ScanInfos.begin(); it != this->ScanInfos.end(); ++it)
+    {
+    const ScanInfo& info = it->second;
+    // A file modified during this second may change again without its
+    // modification time changing, so it has to be read again next time.
+    if (info.MTime >= this->RunStartTime)
+      {
+      continue;
+      }
+    outfile << info.MTime << ' ' << info.Size << ' '
+            << (info.ContainsQ_OBJECT ? 1 : 0) << ' '
+            << info.MocIncludes.size() << ' ' << it->first << '\n';
+    for (std::vector<std::string>::const_iterator
+           mit = info.MocIncludes.begin(); mit != info.MocIncludes.end();
+         ++mit)
+      {
+      outfile << *mit << '\n';
+      }
+    }
+  outfile.close();
+}
+
+
 void cmQtAutomoc::Init()
 {
   this->OutMocCppFilename = this->Builddir;
@@ -564,6 +651,8 @@ bool cmQtAutomoc::RunAutomoc()
       }
     }
 
+  this->RunMocJobs();
+
   if (this->RunMocFailed)
     {
     std::cerr << "returning failed.."<< std::endl;
@@ -597,12 +686,8 @@ void cmQtAutomoc::ParseCppFile(const std::string& absFilename,
                               const std::list<std::string>& headerExtensions,
                               std::map<std::string, std::string>& includedMocs)
 {
-  cmsys::RegularExpression mocIncludeRegExp(
-              "[\n][ \t]*#[ \t]*include[ \t]+"
-              "[\"<](([^ \">]+/)?moc_[^ \">/]+\\.cpp|[^ \">]+\\.moc)[\">]");
-
-  const std::string contentsString = this->ReadAll(absFilename);
-  if (contentsString.empty())
+  const ScanInfo& scanInfo = this->ScanFile(absFilename);
+  if (scanInfo.Size == 0)
     {
     std::cerr << "AUTOMOC: warning: " << absFilename << ": file is empty\n"
               << std::endl;
@@ -612,128 +697,122 @@ void cmQtAutomoc::ParseCppFile(const std::string& absFilename,
                    cmsys::SystemTools::GetRealPath(absFilename.c_str())) + '/';
   const std::string scannedFileBasename = cmsys::SystemTools::
                                   GetFilenameWithoutLastExtension(absFilename);
-  const bool cppContainsQ_OBJECT = containsQ_OBJECT(contentsString);
+  const bool cppContainsQ_OBJECT = scanInfo.ContainsQ_OBJECT;
   bool dotMocIncluded = false;
   bool mocUnderscoreIncluded = false;
   std::string ownMocUnderscoreFile;
   std::string ownDotMocFile;
   std::string ownMocHeaderFile;
 
-  std::string::size_type matchOffset = 0;
-  // first a simply string check for "moc" is *much* faster than the regexp,
-  // and if the string search already fails, we don't have to try the
-  // expensive regexp
-  if ((strstr(contentsString.c_str(), "moc") != NULL)
-                                    && (mocIncludeRegExp.find(contentsString)))
+  // for every moc include in the file
+  for (std::vector<std::string>::const_iterator
+         mocIt = scanInfo.MocIncludes.begin();
+       mocIt != scanInfo.MocIncludes.end();
+       ++mocIt)
     {
-    // for every moc include in the file
-    do
+    const std::string& currentMoc = *mocIt;
+    //std::cout << "found moc include: " << currentMoc << std::endl;
+
+    std::string basename = cmsys::SystemTools::
+                                 GetFilenameWithoutLastExtension(currentMoc);
+    const bool moc_style = this->StartsWith(basename, "moc_");
+
+    // If the moc include is of the moc_foo.cpp style we expect
+    // the Q_OBJECT class declaration in a header file.
+    // If the moc include is of the foo.moc style we need to look for
+    // a Q_OBJECT macro in the current source file, if it contains the
+    // macro we generate the moc file from the source file.
+    // Q_OBJECT
+    if (moc_style)
       {
-      const std::string currentMoc = mocIncludeRegExp.match(1);
-      //std::cout << "found moc include: " << currentMoc << std::endl;
-
-      std::string basename = cmsys::SystemTools::
-                                   GetFilenameWithoutLastExtension(currentMoc);
-      const bool moc_style = this->StartsWith(basename, "moc_");
-
-      // If the moc include is of the moc_foo.cpp style we expect
-      // the Q_OBJECT class declaration in a header file.
-      // If the moc include is of the foo.moc style we need to look for
-      // a Q_OBJECT macro in the current source file, if it contains the
-      // macro we generate the moc file from the source file.
-      // Q_OBJECT
-      if (moc_style)
+      // basename should be the part of the moc filename used for
+      // finding the correct header, so we need to remove the moc_ part
+      basename = basename.substr(4);
+      std::string mocSubDir = extractSubDir(absPath, currentMoc);
+      std::string headerToMoc = findMatchingHeader(
+                             absPath, mocSubDir, basename, headerExtensions);
+
+      if (!headerToMoc.empty())
         {
-        // basename should be the part of the moc filename used for
-        // finding the correct header, so we need to remove the moc_ part
-        basename = basename.substr(4);
-        std::string mocSubDir = extractSubDir(absPath, currentMoc);
-        std::string headerToMoc = findMatchingHeader(
-                               absPath, mocSubDir, basename, headerExtensions);
-
-        if (!headerToMoc.empty())
+        includedMocs[headerToMoc] = currentMoc;
+        if (basename == scannedFileBasename)
           {
-          includedMocs[headerToMoc] = currentMoc;
-          if (basename == scannedFileBasename)
-            {
-            mocUnderscoreIncluded = true;
-            ownMocUnderscoreFile = currentMoc;
-            ownMocHeaderFile = headerToMoc;
-            }
+          mocUnderscoreIncluded = true;
+          ownMocUnderscoreFile = currentMoc;
+          ownMocHeaderFile = headerToMoc;
+          }
+        }
+      else
+        {
+        std::cerr << "AUTOMOC: error: " << absFilename << " The file "
+                  << "includes the moc file \"" << currentMoc << "\", "
+                  << "but could not find header \"" << basename
+                  << '{' << this->Join(headerExtensions, ',') << "}\" ";
+        if (mocSubDir.empty())
+          {
+          std::cerr << "in " << absPath << "\n" << std::endl;
           }
         else
           {
-          std::cerr << "AUTOMOC: error: " << absFilename << " The file "
-                    << "includes the moc file \"" << currentMoc << "\", "
-                    << "but could not find header \"" << basename
-                    << '{' << this->Join(headerExtensions, ',') << "}\" ";
-          if (mocSubDir.empty())
-            {
-            std::cerr << "in " << absPath << "\n" << std::endl;
-            }
-          else
-            {
-            std::cerr << "neither in " << absPath
-                      << " nor in " << mocSubDir << "\n" << std::endl;
-            }
-
-          ::exit(EXIT_FAILURE);
+          std::cerr << "neither in " << absPath
+                    << " nor in " << mocSubDir << "\n" << std::endl;
           }
+
+        ::exit(EXIT_FAILURE);
         }
-      else
+      }
+    else
+      {
+      std::string fileToMoc = absFilename;
+      if ((basename != scannedFileBasename) || (cppContainsQ_OBJECT==false))
         {
-        std::string fileToMoc = absFilename;
-        if ((basename != scannedFileBasename) || (cppContainsQ_OBJECT==false))
+        std::string mocSubDir = extractSubDir(absPath, currentMoc);
+        std::string headerToMoc = findMatchingHeader(
+                            absPath, mocSubDir, basename, headerExtensions);
+        if (!headerToMoc.empty())
           {
-          std::string mocSubDir = extractSubDir(absPath, currentMoc);
-          std::string headerToMoc = findMatchingHeader(
-                              absPath, mocSubDir, basename, headerExtensions);
-          if (!headerToMoc.empty())
+          // this is for KDE4 compatibility:
+          fileToMoc = headerToMoc;
+          if ((cppContainsQ_OBJECT==false) &&(basename==scannedFileBasename))
             {
-            // this is for KDE4 compatibility:
-            fileToMoc = headerToMoc;
-            if ((cppContainsQ_OBJECT==false) &&(basename==scannedFileBasename))
-              {
-              std::cerr << "AUTOMOC: warning: " << absFilename << ": The file "
-                            "includes the moc file \"" << currentMoc <<
-                            "\", but does not contain a Q_OBJECT macro. "
-                            "Running moc on "
-                        << "\"" << headerToMoc << "\" ! Include \"moc_"
-                        << basename << ".cpp\" for a compatiblity with "
-                           "strict mode (see CMAKE_AUTOMOC_RELAXED_MODE).\n"
-                        << std::endl;
-              }
-            else
-              {
-              std::cerr << "AUTOMOC: warning: " << absFilename << ": The file "
-                            "includes the moc file \"" << currentMoc <<
-                            "\" instead of \"moc_" << basename << ".cpp\". "
-                            "Running moc on "
-                        << "\"" << headerToMoc << "\" ! Include \"moc_"
-                        << basename << ".cpp\" for compatiblity with "
-                           "strict mode (see CMAKE_AUTOMOC_RELAXED_MODE).\n"
-                        << std::endl;
-              }
+            std::cerr << "AUTOMOC: warning: " << absFilename << ": The file "
+                          "includes the moc file \"" << currentMoc <<
+                          "\", but does not contain a Q_OBJECT macro. "
+                          "Running moc on "
+                      << "\"" << headerToMoc << "\" ! Include \"moc_"
+                      << basename << ".cpp\" for a compatiblity with "
+                         "strict mode (see CMAKE_AUTOMOC_RELAXED_MODE).\n"
+                      << std::endl;
             }
           else
             {
-            std::cerr <<"AUTOMOC: error: " << absFilename << ": The file "
-                        "includes the moc file \"" << currentMoc <<
-                        "\", which seems to be the moc file from a different "
-                        "source file. CMake also could not find a matching "
-                        "header.\n" << std::endl;
-            ::exit(EXIT_FAILURE);
+            std::cerr << "AUTOMOC: warning: " << absFilename << ": The file "
+                          "includes the moc file \"" << currentMoc <<
+                          "\" instead of \"moc_" << basename << ".cpp\". "
+                          "Running moc on "
+                      << "\"" << headerToMoc << "\" ! Include \"moc_"
+                      << basename << ".cpp\" for compatiblity with "
+                         "strict mode (see CMAKE_AUTOMOC_RELAXED_MODE).\n"
+                      << std::endl;
             }
           }
         else
           {
-          dotMocIncluded = true;
-          ownDotMocFile = currentMoc;
+          std::cerr <<"AUTOMOC: error: " << absFilename << ": The file "
+                      "includes the moc file \"" << currentMoc <<
+                      "\", which seems to be the moc file from a different "
+                      "source file. CMake also could not find a matching "
+                      "header.\n" << std::endl;
+          ::exit(EXIT_FAILURE);
           }
-        includedMocs[fileToMoc] = currentMoc;
         }
-      matchOffset += mocIncludeRegExp.end();
-      } while(mocIncludeRegExp.find(contentsString.c_str() + matchOffset));
+      else
+        {
+        dotMocIncluded = true;
+        ownDotMocFile = currentMoc;
+        }
+      includedMocs[fileToMoc] = currentMoc;
+      }
     }
 
   // In this case, check whether the scanned file itself contains a Q_OBJECT.
@@ -775,12 +854,8 @@ void cmQtAutomoc::StrictParseCppFile(const std::string& absFilename,
                               const std::list<std::string>& headerExtensions,
                               std::map<std::string, std::string>& includedMocs)
 {
-  cmsys::RegularExpression mocIncludeRegExp(
-              "[\n][ \t]*#[ \t]*include[ \t]+"
-              "[\"<](([^ \">]+/)?moc_[^ \">/]+\\.cpp|[^ \">]+\\.moc)[\">]");
-
-  const std::string contentsString = this->ReadAll(absFilename);
-  if (contentsString.empty())
+  const ScanInfo& scanInfo = this->ScanFile(absFilename);
+  if (scanInfo.Size == 0)
     {
     std::cerr << "AUTOMOC: warning: " << absFilename << ": file is empty\n"
               << std::endl;
@@ -793,83 +868,77 @@ void cmQtAutomoc::StrictParseCppFile(const std::string& absFilename,
 
   bool dotMocIncluded = false;
 
-  std::string::size_type matchOffset = 0;
-  // first a simply string check for "moc" is *much* faster than the regexp,
-  // and if the string search already fails, we don't have to try the
-  // expensive regexp
-  if ((strstr(contentsString.c_str(), "moc") != NULL)
-                                    && (mocIncludeRegExp.find(contentsString)))
+  // for every moc include in the file
+  for (std::vector<std::string>::const_iterator
+         mocIt = scanInfo.MocIncludes.begin();
+       mocIt != scanInfo.MocIncludes.end();
+       ++mocIt)
     {
-    // for every moc include in the file
-    do
+    const std::string& currentMoc = *mocIt;
+
+    std::string basename = cmsys::SystemTools::
+                                 GetFilenameWithoutLastExtension(currentMoc);
+    const bool mocUnderscoreStyle = this->StartsWith(basename, "moc_");
+
+    // If the moc include is of the moc_foo.cpp style we expect
+    // the Q_OBJECT class declaration in a header file.
+    // If the moc include is of the foo.moc style we need to look for
+    // a Q_OBJECT macro in the current source file, if it contains the
+    // macro we generate the moc file from the source file.
+    if (mocUnderscoreStyle)
       {
-      const std::string currentMoc = mocIncludeRegExp.match(1);
-
-      std::string basename = cmsys::SystemTools::
-                                   GetFilenameWithoutLastExtension(currentMoc);
-      const bool mocUnderscoreStyle = this->StartsWith(basename, "moc_");
-
-      // If the moc include is of the moc_foo.cpp style we expect
-      // the Q_OBJECT class declaration in a header file.
-      // If the moc include is of the foo.moc style we need to look for
-      // a Q_OBJECT macro in the current source file, if it contains the
-      // macro we generate the moc file from the source file.
-      if (mocUnderscoreStyle)
+      // basename should be the part of the moc filename used for
+      // finding the correct header, so we need to remove the moc_ part
+      basename = basename.substr(4);
+      std::string mocSubDir = extractSubDir(absPath, currentMoc);
+      std::string headerToMoc = findMatchingHeader(
+                             absPath, mocSubDir, basename, headerExtensions);
+
+      if (!headerToMoc.empty())
         {
-        // basename should be the part of the moc filename used for
-        // finding the correct header, so we need to remove the moc_ part
-        basename = basename.substr(4);
-        std::string mocSubDir = extractSubDir(absPath, currentMoc);
-        std::string headerToMoc = findMatchingHeader(
-                               absPath, mocSubDir, basename, headerExtensions);
-
-        if (!headerToMoc.empty())
+        includedMocs[headerToMoc] = currentMoc;
+        }
+      else
+        {
+        std::cerr << "AUTOMOC: error: " << absFilename << " The file "
+                  << "includes the moc file \"" << currentMoc << "\", "
+                  << "but could not find header \"" << basename
+                  << '{' << this->Join(headerExtensions, ',') << "}\" ";
+        if (mocSubDir.empty())
           {
-          includedMocs[headerToMoc] = currentMoc;
+          std::cerr << "in " << absPath << "\n" << std::endl;
           }
         else
           {
-          std::cerr << "AUTOMOC: error: " << absFilename << " The file "
-                    << "includes the moc file \"" << currentMoc << "\", "
-                    << "but could not find header \"" << basename
-                    << '{' << this->Join(headerExtensions, ',') << "}\" ";
-          if (mocSubDir.empty())
-            {
-            std::cerr << "in " << absPath << "\n" << std::endl;
-            }
-          else
-            {
-            std::cerr << "neither in " << absPath
-                      << " nor in " << mocSubDir << "\n" << std::endl;
-            }
-
-          ::exit(EXIT_FAILURE);
+          std::cerr << "neither in " << absPath
+                    << " nor in " << mocSubDir << "\n" << std::endl;
           }
+
+        ::exit(EXIT_FAILURE);
         }
-      else
+      }
+    else
+      {
+      if (basename != scannedFileBasename)
         {
-        if (basename != scannedFileBasename)
-          {
-          std::cerr <<"AUTOMOC: error: " << absFilename << ": The file "
-                      "includes the moc file \"" << currentMoc <<
-                      "\", which seems to be the moc file from a different "
-                      "source file. This is not supported. "
-                      "Include \"" << scannedFileBasename << ".moc\" to run "
-                      "moc on this source file.\n" << std::endl;
-          ::exit(EXIT_FAILURE);
-          }
-        dotMocIncluded = true;
-        includedMocs[absFilename] = currentMoc;
+        std::cerr <<"AUTOMOC: error: " << absFilename << ": The file "
+                    "includes the moc file \"" << currentMoc <<
+                    "\", which seems to be the moc file from a different "
+                    "source file. This is not supported. "
+                    "Include \"" << scannedFileBasename << ".moc\" to run "
+                    "moc on this source file.\n" << std::endl;
+        ::exit(EXIT_FAILURE);
         }
-      matchOffset += mocIncludeRegExp.end();
-      } while(mocIncludeRegExp.find(contentsString.c_str() + matchOffset));
+      dotMocIncluded = true;
+      includedMocs[absFilename] = currentMoc;
+      }
     }
 
   // In this case, check whether the scanned file itself contains a Q_OBJECT.
   // If this is the case, the moc_foo.cpp should probably be generated from
   // foo.cpp instead of foo.h, because otherwise it won't build.
   // But warn, since this is not how it is supposed to be used.
-  if ((dotMocIncluded == false) && (containsQ_OBJECT(contentsString)))
+  if ((dotMocIncluded == false) && (scanInfo.ContainsQ_OBJECT))
     {
     // otherwise always error out since it will not compile:
     std::cerr << "AUTOMOC: error: " << absFilename << ": The file "
@@ -939,8 +1008,7 @@ void cmQtAutomoc::ParseHeaders(const std::set<std::string>& absHeaders,
                                    GetFilenameWithoutLastExtension(headerName);
 
       const std::string currentMoc = "moc_" + basename + ".cpp";
-      const std::string contents = this->ReadAll(headerName);
-      if (containsQ_OBJECT(contents))
+      if (this->ScanFile(headerName).ContainsQ_OBJECT)
         {
         //std::cout << "header contains Q_OBJECT macro";
         notIncludedMocs[headerName] = currentMoc;
@@ -974,7 +1042,10 @@ bool cmQtAutomoc::GenerateMoc(const std::string& sourceFile,
                                            |cmsysTerminal_Color_ForegroundBold,
                                      msg.c_str(), true, this->ColorOutput);
 
-    std::vector<cmStdString> command;
+    this->MocJobs.push_back(MocJob());
+    MocJob& job = this->MocJobs.back();
+    job.MocFilePath = mocFilePath;
+    std::vector<cmStdString>& command = job.Command;
     command.push_back(this->MocExecutable);
     for (std::list<std::string>::const_iterator it = this->MocIncludes.begin();
          it != this->MocIncludes.end();
@@ -1011,20 +1082,115 @@ bool cmQtAutomoc::GenerateMoc(const std::string& sourceFile,
         }
       std::cout << std::endl;
       }
+    return true;
+    }
+  return false;
+}
+
+
+void cmQtAutomoc::RunMocJobs()
+{
+  // Run the moc invocations queued by GenerateMoc, at most MocJobsMax at
+  // a time.  The output of each is collected when it is the oldest one
+  // still running, so errors are reported in the order of the queue.
+  std::deque<std::pair<cmsysProcess*, size_t> > running;
+  for (size_t i = 0; i <= this->MocJobs.size(); ++i)
+    {
+    while (!running.empty() &&
+           (running.size() >= this->MocJobsMax || i == this->MocJobs.size()))
+      {
+      cmsysProcess* cp = running.front().first;
+      const MocJob& done = this->MocJobs[running.front().second];
+      running.pop_front();
+
+      std::string output;
+      char* data;
+      int length;
+      while (cmsysProcess_WaitForData(cp, &data, &length, 0) > 0)
+        {
+        output.append(data, length);
+        }
+      cmsysProcess_WaitForExit(cp, 0);
+      if (cmsysProcess_GetState(cp) == cmsysProcess_State_Error)
+        {
+        output += cmsysProcess_GetErrorString(cp);
+        }
+      if (cmsysProcess_GetState(cp) != cmsysProcess_State_Exited
+          || cmsysProcess_GetExitValue(cp) != 0)
+        {
+        std::cerr << "AUTOMOC: error: process for " << done.MocFilePath
+                  << " failed:\n" << output << std::endl;
+        this->RunMocFailed = true;
+        cmSystemTools::RemoveFile(done.MocFilePath.c_str());
+        }
+      cmsysProcess_Delete(cp);
+      }
+    if (i == this->MocJobs.size())
+      {
+      break;
+      }
 
-    std::string output;
-    int retVal = 0;
-    bool result = cmSystemTools::RunSingleCommand(command, &output, &retVal);
-    if (!result || retVal)
+    std::vector<const char*> argv;
+    const std::vector<cmStdString>& command = this->MocJobs[i].Command;
+    for (std::vector<cmStdString>::const_iterator it = command.begin();
+         it != command.end();
+         ++it)
       {
-      std::cerr << "AUTOMOC: error: process for " << mocFilePath <<" failed:\n"
-                << output << std::endl;
-      this->RunMocFailed = true;
-      cmSystemTools::RemoveFile(mocFilePath.c_str());
+      argv.push_back(it->c_str());
       }
-    return true;
+    argv.push_back(0);
+
+    cmsysProcess* cp = cmsysProcess_New();
+    cmsysProcess_SetCommand(cp, &*argv.begin());
+    cmsysProcess_SetOption(cp, cmsysProcess_Option_HideWindow, 1);
+    cmsysProcess_Execute(cp);
+    running.push_back(std::make_pair(cp, i));
     }
-  return false;
+  this->MocJobs.clear();
+}
+
+
+const cmQtAutomoc::ScanInfo&
+cmQtAutomoc::ScanFile(const std::string& absFilename)
+{
+  std::map<std::string, ScanInfo>::iterator it =
+                                           this->ScanInfos.find(absFilename);
+  if (it != this->ScanInfos.end())
+    {
+    return it->second;
+    }
+
+  ScanInfo& info = this->ScanInfos[absFilename];
+  info.MTime = cmsys::SystemTools::ModifiedTime(absFilename.c_str());
+  info.Size = cmsys::SystemTools::FileLength(absFilename.c_str());
+  std::map<std::string, ScanInfo>::const_iterator old =
+                                        this->OldScanInfos.find(absFilename);
+  if (old != this->OldScanInfos.end() &&
+      old->second.MTime == info.MTime && old->second.Size == info.Size)
+    {
+    // unchanged since the last run, don't read it again
+    info = old->second;
+    return info;
+    }
+
+  const std::string contentsString = this->ReadAll(absFilename);
+  info.ContainsQ_OBJECT = containsQ_OBJECT(contentsString);
+
+  // first a simply string check for "moc" is *much* faster than the regexp,
+  // and if the string search already fails, we don't have to try the
+  // expensive regexp
+  cmsys::RegularExpression mocIncludeRegExp(mocIncludePattern);
+  std::string::size_type matchOffset = 0;
+  if ((strstr(contentsString.c_str(), "moc") != NULL)
+                                    && (mocIncludeRegExp.find(contentsString)))
+    {
+    do
+      {
+      info.MocIncludes.push_back(mocIncludeRegExp.match(1));
+      matchOffset += mocIncludeRegExp.end();
+      } while(mocIncludeRegExp.find(contentsString.c_str() + matchOffset));
+    }
+  return info;
 }
 
 
@@ -34,10 +34,13 @@ private:
   bool ReadOldMocDefinitionsFile(cmMakefile* makefile,
                                  const char* targetDirectory);
   void WriteOldMocDefinitionsFile(const char* targetDirectory);
+  void ReadScanCacheFile(const char* targetDirectory);
+  void WriteScanCacheFile(const char* targetDirectory);
 
   bool RunAutomoc();
   bool GenerateMoc(const std::string& sourceFile,
                    const std::string& mocFileName);
+  void RunMocJobs();
   void ParseCppFile(const std::string& absFilename,
                     const std::list<std::string>& headerExtensions,
                     std::map<std::string, std::string>& includedMocs);
@@ -59,6 +62,25 @@ private:
   bool StartsWith(const std::string& str, const std::string& with);
   std::string ReadAll(const std::string& filename);
 
+  // What scanning a file found.  The results are kept across runs in
+  // AutomocScanCache.txt and reused while the file's modification time
+  // and size are unchanged.
+  struct ScanInfo
+  {
+    long MTime;
+    unsigned long Size;
+    bool ContainsQ_OBJECT;
+    std::vector<std::string> MocIncludes;
+  };
+  const ScanInfo& ScanFile(const std::string& absFilename);
+
+  // A moc invocation queued by GenerateMoc for RunMocJobs.
+  struct MocJob
+  {
+    std::string MocFilePath;
+    std::vector<cmStdString> Command;
+  };
+
   std::string QtMajorVersion;
   std::string Sources;
   std::string Headers;
@@ -87,6 +109,13 @@ private:
   bool GenerateAll;
   bool RelaxedMode;
 
+  unsigned int MocJobsMax;
+  std::vector<MocJob> MocJobs;
+
+  long RunStartTime;
+  std::map<std::string, ScanInfo> OldScanInfos;
+  std::map<std::string, ScanInfo> ScanInfos;
+
 };
 
 #endif
@@ -290,7 +290,7 @@ bool cmStringCommand::RegexMatch(std::vector<std::string> const& args)
   this->ClearMatches(this->Makefile);
   // Compile the regular expression.
   cmsys::RegularExpression re;
-  if(!re.compile(regex.c_str()))
+  if(!cmStringCommand::CompileRegex(regex.c_str(), re))
     {
     std::string e = 
       "sub-command REGEX, mode MATCH failed to compile regex \""+regex+"\".";
@@ -339,7 +339,7 @@ bool cmStringCommand::RegexMatchAll(std::vector<std::string> const& args)
   this->ClearMatches(this->Makefile);
   // Compile the regular expression.
   cmsys::RegularExpression re;
-  if(!re.compile(regex.c_str()))
+  if(!cmStringCommand::CompileRegex(regex.c_str(), re))
     {
     std::string e =
       "sub-command REGEX, mode MATCHALL failed to compile regex \""+
@@ -351,9 +351,10 @@ bool cmStringCommand::RegexMatchAll(std::vector<std::string> const& args)
   // Scan through the input for all matches.
   std::string output;
   const char* p = input.c_str();
+  const char* last = 0;
   while(re.find(p))
     {
-    this->StoreMatches(this->Makefile, re);
+    last = p;
     std::string::size_type l = re.start();
     std::string::size_type r = re.end();
     if(r-l == 0)
@@ -370,6 +371,12 @@ bool cmStringCommand::RegexMatchAll(std::vector<std::string> const& args)
     output += std::string(p+l, r-l);
     p += r;
     }
+
+  // Store the sub-expressions of the last match.
+  if(last && re.find(last))
+    {
+    this->StoreMatches(this->Makefile, re);
+    }
   
   // Store the output in the provided variable.
   this->Makefile->AddDefinition(outvar.c_str(), output.c_str());
@@ -443,7 +450,7 @@ bool cmStringCommand::RegexReplace(std::vector<std::string> const& args)
   this->ClearMatches(this->Makefile);
   // Compile the regular expression.
   cmsys::RegularExpression re;
-  if(!re.compile(regex.c_str()))
+  if(!cmStringCommand::CompileRegex(regex.c_str(), re))
     {
     std::string e = 
       "sub-command REGEX, mode REPLACE failed to compile regex \""+
@@ -455,9 +462,10 @@ bool cmStringCommand::RegexReplace(std::vector<std::string> const& args)
   // Scan through the input for all matches.
   std::string output;
   std::string::size_type base = 0;
+  std::string::size_type last = std::string::npos;
   while(re.find(input.c_str()+base))
     {
-    this->StoreMatches(this->Makefile, re);
+    last = base;
     std::string::size_type l2 = re.start();
     std::string::size_type r = re.end();
     
@@ -508,6 +516,12 @@ bool cmStringCommand::RegexReplace(std::vector<std::string> const& args)
     // Move past the match.
     base += r;
     }
+
+  // Store the sub-expressions of the last match.
+  if(last != std::string::npos && re.find(input.c_str()+last))
+    {
+    this->StoreMatches(this->Makefile, re);
+    }
   
   // Concatenate the text after the last match.
   output += input.substr(base, input.length()-base);
@@ -879,3 +893,31 @@ bool cmStringCommand
   this->Makefile->AddDefinition(variableName.c_str(), &*result.begin());
   return true;
 }
+
+//----------------------------------------------------------------------------
+bool cmStringCommand::CompileRegex(const char* regex,
+                                   cmsys::RegularExpression& re)
+{
+  // Keep the cache bounded in case a project uses many distinct
+  // expressions, e.g. ones built from variable values.
+  typedef std::map<cmStdString, cmsys::RegularExpression> RegexCacheType;
+  static RegexCacheType regexCache;
+  RegexCacheType::const_iterator i = regexCache.find(regex);
+  if(i != regexCache.end())
+    {
+    // Copy the compiled program so that nested uses of the same
+    // expression do not share match state.
+    re = i->second;
+    return true;
+    }
+  if(!re.compile(regex))
+    {
+    return false;
+    }
+  if(regexCache.size() >= 1000)
+    {
+    regexCache.clear();
+    }
+  regexCache[regex] = re;
+  return true;
+}
@@ -147,6 +147,13 @@ public:
   cmTypeMacro(cmStringCommand, cmCommand);
   static void ClearMatches(cmMakefile* mf);
   static void StoreMatches(cmMakefile* mf, cmsys::RegularExpression& re);
+
+  /**
+   * Compile the given regular expression into re.  Compiled programs
+   * are cached by pattern so repeated use of the same expression does
+   * not compile it again.  Returns false if the expression is invalid.
+   */
+  static bool CompileRegex(const char* regex, cmsys::RegularExpression& re);
 protected:
   bool HandleConfigureCommand(std::vector<std::string> const& args);
   bool HandleAsciiCommand(std::vector<std::string> const& args);
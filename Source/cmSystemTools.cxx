@@ -1705,7 +1705,8 @@ bool cmSystemTools::IsPathToFramework(const char* path)
 
 bool cmSystemTools::CreateTar(const char* outFileName,
                               const std::vector<cmStdString>& files,
-                              bool gzip, bool bzip2, bool verbose)
+                              bool gzip, bool bzip2, bool verbose,
+                              unsigned int jobs)
 {
 #if defined(CMAKE_BUILD_WITH_CMAKE)
   std::string cwd = cmSystemTools::GetCurrentWorkingDirectory();
@@ -1719,10 +1720,13 @@ bool cmSystemTools::CreateTar(const char* outFileName,
     cmSystemTools::Error(e.c_str());
     return false;
     }
+  // Compressed blocks are kept next to the output file.
+  std::string tempDir = cmSystemTools::CollapseFullPath(outFileName);
+  tempDir = cmSystemTools::GetFilenamePath(tempDir);
   cmArchiveWrite a(fout, (gzip? cmArchiveWrite::CompressGZip :
                           (bzip2? cmArchiveWrite::CompressBZip2 :
                            cmArchiveWrite::CompressNone)),
-                           cmArchiveWrite::TypeTAR);
+                           cmArchiveWrite::TypeTAR, jobs, tempDir.c_str());
   a.SetVerbose(verbose);
   for(std::vector<cmStdString>::const_iterator i = files.begin();
       i != files.end(); ++i)
@@ -1738,7 +1742,7 @@ bool cmSystemTools::CreateTar(const char* outFileName,
       break;
       }
     }
-  if(!a)
+  if(!a.Finish())
     {
     cmSystemTools::Error(a.GetError().c_str());
     return false;
@@ -1749,6 +1753,7 @@ bool cmSystemTools::CreateTar(const char* outFileName,
   (void)files;
   (void)gzip;
   (void)verbose;
+  (void)jobs;
   return false;
 #endif
 }
@@ -29,6 +29,7 @@
 #if defined(CMAKE_BUILD_WITH_CMAKE)
 # include "cmGraphVizWriter.h"
 # include "cmDependsFortran.h" // For -E cmake_copy_f90_mod callback.
+# include "cmArchiveWrite.h" // For -E cmake_compress_block callback.
 # include "cmVariableWatch.h"
 # include <cmsys/Terminal.h>
 # include <cmsys/CommandLineArguments.hxx>
@@ -1133,9 +1134,13 @@ void CMakeCommandUsage(const char* program)
     << "  remove_directory dir      - remove a directory and its contents\n"
     << "  rename oldname newname    - rename a file or directory "
        "(on one volume)\n"
+    << "  sleep <number>...         - sleep for the given number of "
+       "seconds\n"
     << "  tar [cxt][vfz][cvfj] file.tar "
     "file/dir1 file/dir2 ... - create a tar "
     "archive\n"
+    << "                            (compressed by $CMAKE_ARCHIVE_JOBS "
+    "processes)\n"
     << "  time command [args] ...   - run command and return elapsed time\n"
     << "  touch file                - touch a file.\n"
     << "  touch_nocreate file       - touch a file but do not create it.\n"
@@ -1341,6 +1346,29 @@ int cmake::ExecuteCMakeCommand(std::vector<std::string>& args)
       return 0;
       }
 
+    // Sleep command
+    else if (args[1] == "sleep" && args.size() > 2)
+      {
+      double total = 0;
+      for(size_t i = 2; i < args.size(); ++i)
+        {
+        double num = 0;
+        char extra;
+        if(sscanf(args[i].c_str(), "%lg%c", &num, &extra) != 1 || num < 0)
+          {
+          std::cerr << "Unknown sleep time format \"" << args[i]
+                    << "\".\n";
+          return 1;
+          }
+        total += num;
+        }
+      if(total > 0)
+        {
+        cmSystemTools::Delay(static_cast<unsigned int>(total*1000));
+        }
+      return 0;
+      }
+
     // Clock command
     else if (args[1] == "time" && args.size() > 2)
       {
@@ -1701,6 +1729,12 @@ int cmake::ExecuteCMakeCommand(std::vector<std::string>& args)
         automoc.Run(args[2].c_str());
         return 0;
       }
+    // Internal support for archives compressed by several processes.
+    else if (args[1] == "cmake_compress_block" && args.size() == 5)
+      {
+      return cmArchiveWrite::CompressBlock(args[2].c_str(), args[3].c_str(),
+                                           args[4].c_str())? 0 : 1;
+      }
 #endif
 
     // Tar files
@@ -1739,8 +1773,15 @@ int cmake::ExecuteCMakeCommand(std::vector<std::string>& args)
         }
       else if ( flags.find_first_of('c') != flags.npos )
         {
+        // Compress with several processes if requested.
+        unsigned int jobs = 1;
+        if(const char* jobsVar = cmSystemTools::GetEnv("CMAKE_ARCHIVE_JOBS"))
+          {
+          int value = atoi(jobsVar);
+          jobs = value > 1? static_cast<unsigned int>(value) : 1;
+          }
         if ( !cmSystemTools::CreateTar(
-               outFile.c_str(), files, gzip, bzip2, verbose) )
+               outFile.c_str(), files, gzip, bzip2, verbose, jobs) )
           {
           cmSystemTools::Error("Problem creating tar: ", outFile.c_str());
           return 1;
@@ -2501,7 +2542,17 @@ int cmake::Generate()
     {
     return -1;
     }
+  // Track content hashes of generated files to avoid reading back
+  // unchanged copy-if-different outputs on the next generate.
+  std::string hashes = this->GetHomeOutputDirectory();
+  hashes += this->GetCMakeFilesDirectory();
+  hashes += "/CMakeGeneratedFileHashes.txt";
+  bool ownHashes = cmGeneratedFileStream::EnableContentHashes(hashes.c_str());
   this->GlobalGenerator->Generate();
+  if(ownHashes)
+    {
+    cmGeneratedFileStream::DisableContentHashes();
+    }
   if(this->WarnUnusedCli)
     {
     this->RunCheckForUnusedVariables();
@@ -2926,6 +2977,16 @@ int cmake::CheckBuildSystem()
                                             &result) ||
      result < 0)
     {
+    // If the content of every newer dependency is unchanged there is
+    // no need to rerun.  Touch the outputs to avoid checking again.
+    if(this->CheckBuildSystemDependHashes(mf, depends, out_oldest, verbose))
+      {
+      for(out = outputs.begin(); out != outputs.end(); ++out)
+        {
+        cmSystemTools::Touch(out->c_str(), false);
+        }
+      return 0;
+      }
     if(verbose)
       {
       cmOStringStream msg;
@@ -2941,6 +3002,61 @@ int cmake::CheckBuildSystem()
   return 0;
 }
 
+//----------------------------------------------------------------------------
+bool
+cmake::CheckBuildSystemDependHashes(cmMakefile* mf,
+                                    std::vector<std::string> const& depends,
+                                    std::string const& out_oldest,
+                                    bool verbose)
+{
+#if defined(CMAKE_BUILD_WITH_CMAKE)
+  // The hashes are present only if CMAKE_SKIP_UNCHANGED_REGENERATION
+  // was enabled when the build system was generated.
+  std::vector<std::string> hashes;
+  if(const char* hashStr = mf->GetDefinition("CMAKE_MAKEFILE_DEPENDS_MD5"))
+    {
+    cmSystemTools::ExpandListArgument(hashStr, hashes, true);
+    }
+  if(hashes.size() != depends.size())
+    {
+    return false;
+    }
+
+  for(std::vector<std::string>::size_type i = 0; i < depends.size(); ++i)
+    {
+    int result = 0;
+    if(this->FileComparison->FileTimeCompare(out_oldest.c_str(),
+                                             depends[i].c_str(), &result) &&
+       result >= 0)
+      {
+      // This dependency is not newer than the build system.
+      continue;
+      }
+    char md5[32];
+    if(hashes[i].size() != 32 ||
+       !cmSystemTools::ComputeFileMD5(depends[i].c_str(), md5) ||
+       strncmp(md5, hashes[i].c_str(), 32) != 0)
+      {
+      return false;
+      }
+    if(verbose)
+      {
+      cmOStringStream msg;
+      msg << "Build system dependency content unchanged: "
+          << depends[i] << "\n";
+      cmSystemTools::Stdout(msg.str().c_str());
+      }
+    }
+  return true;
+#else
+  (void)mf;
+  (void)depends;
+  (void)out_oldest;
+  (void)verbose;
+  return false;
+#endif
+}
+
 //----------------------------------------------------------------------------
 void cmake::TruncateOutputLog(const char* fname)
 {
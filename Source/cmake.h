@@ -435,6 +435,15 @@ protected:
    */
   int CheckBuildSystem();
 
+  /**
+   * Check whether every dependency newer than the given output has
+   * the content hash recorded when the build system was generated.
+   */
+  bool CheckBuildSystemDependHashes(cmMakefile* mf,
+                                    std::vector<std::string> const& depends,
+                                    std::string const& out_oldest,
+                                    bool verbose);
+
   void SetDirectoriesFromFile(const char* arg);
 
   //! Make sure all commands are what they say they are and there is no
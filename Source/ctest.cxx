@@ -71,7 +71,8 @@ static const char * cmDocumentationOptions[][3] =
   {"-j <jobs>, --parallel <jobs>", "Run the tests in parallel using the"
    "given number of jobs.",
    "This option tells ctest to run the tests in parallel using given "
-   "number of jobs."},
+   "number of jobs. The coverage step also runs up to this many gcov "
+   "processes at once."},
   {"-Q,--quiet", "Make ctest quiet.",
     "This option will suppress all the output. The output log file will "
     "still be generated if the --output-log is specified. Options such "
@@ -143,6 +144,32 @@ static const char * cmDocumentationOptions[][3] =
   {"-U, --union", "Take the Union of -I and -R",
    "When both -R and -I are specified by default the intersection of "
    "tests are run. By specifying -U the union of tests is run instead."},
+  {"--shard <index>/<count>", "Run one of several shards of the tests.",
+   "The selected tests are split into <count> shards of about equal total "
+   "cost and only shard number <index>, counting from 1, is run.  The cost "
+   "of each test is taken from its COST property, or from the file given "
+   "by --shard-cost-data.  Tests that depend on each other or share a "
+   "RESOURCE_LOCK are always put in the same shard."},
+  {"--shard-cost-data <file>", "Balance shards using a cost data file.",
+   "Read the cost of each test from <file>, in the format of the "
+   "CTestCostData.txt written by earlier runs, when splitting the tests "
+   "with --shard.  Every shard must be given the same file, such as the "
+   "one written by --merge-results, to compute the same split."},
+  {"--merge-results <dir>", "Merge the test results of a shard.",
+   "Combine the Test.xml, the test log and the cost data written by the "
+   "ctest run in build tree <dir> with those of the other trees given by "
+   "this option.  The result is written to the Testing directory of the "
+   "current directory so that it can be submitted as one report.  This "
+   "option may be repeated."},
+  {"--fail-on-performance-regression", "Fail when tests became slower.",
+   "ctest keeps the time and resident size of the last passing runs of "
+   "each test in the build tree.  A test whose time or size exceeds the "
+   "mean of these runs both by CTEST_CUSTOM_PERFORMANCE_THRESHOLD_SIGMA "
+   "standard deviations and by CTEST_CUSTOM_PERFORMANCE_THRESHOLD_PERCENT "
+   "percent (3 and 20 by default) is reported as slower than in earlier "
+   "runs.  With this option such a test also makes ctest fail.  The number "
+   "of runs kept is set by CTEST_CUSTOM_TEST_HISTORY_SIZE (20 by default, "
+   "0 disables the history)."},
   {"--max-width <width>", "Set the max width for a test name to output",
    "Set the maximum width for each test name to show in the output.  This "
    "allows the user to widen the output to avoid clipping the test name which "
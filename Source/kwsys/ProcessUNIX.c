@@ -63,6 +63,13 @@ do.
 #include <dirent.h>    /* DIR, dirent */
 #include <ctype.h>     /* isspace */
 
+/* Platforms on which wait4 reports the resources used by a child.  */
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__NetBSD__) || defined(__OpenBSD__) || defined(__CYGWIN__)
+# define KWSYSPE_USE_WAIT4 1
+# include <sys/resource.h> /* struct rusage, wait4 */
+#endif
+
 #ifdef __HAIKU__
 #undef __BEOS__
 #endif
@@ -156,6 +163,10 @@ static int kwsysProcessSetNonBlocking(int fd);
 static int kwsysProcessCreate(kwsysProcess* cp, int prIndex,
                               kwsysProcessCreateInformation* si, int* readEnd);
 static void kwsysProcessDestroy(kwsysProcess* cp);
+#if KWSYSPE_USE_WAIT4
+static void kwsysProcessAddResourceUsage(kwsysProcess* cp,
+                                         const struct rusage* ru);
+#endif
 static int kwsysProcessSetupOutputPipeFile(int* p, const char* name);
 static int kwsysProcessSetupOutputPipeNative(int* p, int des[2]);
 static int kwsysProcessGetTimeoutTime(kwsysProcess* cp, double* userTimeout,
@@ -272,6 +283,11 @@ struct kwsysProcess_s
   /* The exit codes of each child process in the pipeline.  */
   int* CommandExitCodes;
 
+  /* Resources used by the children reaped so far, and whether any
+     were recorded.  */
+  kwsysProcess_ResourceUsage ResourceUsage;
+  int HasResourceUsage;
+
   /* Name of files to which stdin and stdout pipes are attached.  */
   char* PipeFileSTDIN;
   char* PipeFileSTDOUT;
@@ -708,6 +724,20 @@ const char* kwsysProcess_GetExceptionString(kwsysProcess* cp)
   return "No exception";
 }
 
+/*--------------------------------------------------------------------------*/
+int kwsysProcess_GetResourceUsage(kwsysProcess* cp,
+                                  kwsysProcess_ResourceUsage* usage)
+{
+  if(!cp || !usage || !cp->HasResourceUsage ||
+     (cp->State != kwsysProcess_State_Exited &&
+      cp->State != kwsysProcess_State_Exception))
+    {
+    return 0;
+    }
+  *usage = cp->ResourceUsage;
+  return 1;
+}
+
 /*--------------------------------------------------------------------------*/
 void kwsysProcess_Execute(kwsysProcess* cp)
 {
@@ -1423,6 +1453,8 @@ static int kwsysProcessInitialize(kwsysProcess* cp)
 #endif
   cp->State = kwsysProcess_State_Starting;
   cp->Killed = 0;
+  memset(&cp->ResourceUsage, 0, sizeof(cp->ResourceUsage));
+  cp->HasResourceUsage = 0;
   cp->ExitException = kwsysProcess_Exception_None;
   cp->ExitCode = 1;
   cp->ExitValue = 1;
@@ -1830,6 +1862,32 @@ static int kwsysProcessCreate(kwsysProcess* cp, int prIndex,
   return 1;
 }
 
+/*--------------------------------------------------------------------------*/
+#if KWSYSPE_USE_WAIT4
+/* Accumulate the resources used by one reaped child.  */
+static void kwsysProcessAddResourceUsage(kwsysProcess* cp,
+                                         const struct rusage* ru)
+{
+  kwsysProcess_ResourceUsage* u = &cp->ResourceUsage;
+  long maxrss = (long)ru->ru_maxrss;
+# if defined(__APPLE__)
+  /* Darwin reports the resident size in bytes.  */
+  maxrss /= 1024;
+# endif
+  u->UserTime += ru->ru_utime.tv_sec + ru->ru_utime.tv_usec*0.000001;
+  u->SystemTime += ru->ru_stime.tv_sec + ru->ru_stime.tv_usec*0.000001;
+  if(maxrss > u->MaxResidentSize)
+    {
+    u->MaxResidentSize = maxrss;
+    }
+  u->VoluntaryContextSwitches += (long)ru->ru_nvcsw;
+  u->InvoluntaryContextSwitches += (long)ru->ru_nivcsw;
+  u->BlockInputOperations += (long)ru->ru_inblock;
+  u->BlockOutputOperations += (long)ru->ru_oublock;
+  cp->HasResourceUsage = 1;
+}
+#endif
+
 /*--------------------------------------------------------------------------*/
 static void kwsysProcessDestroy(kwsysProcess* cp)
 {
@@ -1841,13 +1899,23 @@ static void kwsysProcessDestroy(kwsysProcess* cp)
     if(cp->ForkPIDs[i])
       {
       int result;
+#if KWSYSPE_USE_WAIT4
+      struct rusage ru;
+      while(((result = wait4(cp->ForkPIDs[i], &cp->CommandExitCodes[i],
+                             WNOHANG, &ru)) < 0) &&
+            (errno == EINTR));
+#else
       while(((result = waitpid(cp->ForkPIDs[i],
                                &cp->CommandExitCodes[i], WNOHANG)) < 0) &&
             (errno == EINTR));
+#endif
       if(result > 0)
         {
         /* This child has termianted.  */
         cp->ForkPIDs[i] = 0;
+#if KWSYSPE_USE_WAIT4
+        kwsysProcessAddResourceUsage(cp, &ru);
+#endif
         if(--cp->CommandsLeft == 0)
           {
           /* All children have terminated.  Close the signal pipe
@@ -973,6 +973,16 @@ const char* kwsysProcess_GetExceptionString(kwsysProcess* cp)
   return "No exception";
 }
 
+/*--------------------------------------------------------------------------*/
+int kwsysProcess_GetResourceUsage(kwsysProcess* cp,
+                                  kwsysProcess_ResourceUsage* usage)
+{
+  /* Resource usage of the children is not reported on Windows.  */
+  (void)cp;
+  (void)usage;
+  return 0;
+}
+
 /*--------------------------------------------------------------------------*/
 void kwsysProcess_Execute(kwsysProcess* cp)
 {
@@ -0,0 +1,52 @@
+set(dir ${CMAKE_CURRENT_BINARY_DIR}/File-Install-HardLink)
+file(REMOVE_RECURSE ${dir})
+foreach(f linked.txt chmod.txt target.txt relinked.txt rechmod.txt)
+  file(WRITE ${dir}/src/${f} "original\n")
+endforeach()
+
+set(ENV{CMAKE_INSTALL_MODE} HARDLINK)
+file(INSTALL ${dir}/src/linked.txt DESTINATION ${dir}/dst
+  USE_SOURCE_PERMISSIONS)
+file(INSTALL ${dir}/src/chmod.txt DESTINATION ${dir}/dst
+  PERMISSIONS OWNER_READ OWNER_WRITE OWNER_EXECUTE)
+file(INSTALL ${dir}/src/target.txt DESTINATION ${dir}/dst
+  TYPE SHARED_LIBRARY USE_SOURCE_PERMISSIONS)
+
+# A re-install keeps the link if the permissions are unchanged.  It must
+# not change the source through the link if they differ.
+foreach(f relinked.txt rechmod.txt)
+  file(INSTALL ${dir}/src/${f} DESTINATION ${dir}/dst
+    USE_SOURCE_PERMISSIONS)
+endforeach()
+file(INSTALL ${dir}/src/relinked.txt DESTINATION ${dir}/dst
+  USE_SOURCE_PERMISSIONS)
+execute_process(COMMAND ls -l rechmod.txt WORKING_DIRECTORY ${dir}/src
+  OUTPUT_VARIABLE before)
+file(INSTALL ${dir}/src/rechmod.txt DESTINATION ${dir}/dst
+  PERMISSIONS OWNER_READ OWNER_WRITE OWNER_EXECUTE)
+execute_process(COMMAND ls -l rechmod.txt WORKING_DIRECTORY ${dir}/src
+  OUTPUT_VARIABLE after)
+string(REGEX REPLACE " .*" "" before "${before}")
+string(REGEX REPLACE " .*" "" after "${after}")
+if(NOT "${after}" STREQUAL "${before}")
+  message(FATAL_ERROR "Re-install changed the source mode from "
+    "${before} to ${after}")
+endif()
+execute_process(COMMAND ls -l rechmod.txt WORKING_DIRECTORY ${dir}/dst
+  OUTPUT_VARIABLE installed)
+if(NOT installed MATCHES "^-rwx------")
+  message(FATAL_ERROR "Re-install did not set the permissions:\n"
+    "${installed}")
+endif()
+set(ENV{CMAKE_INSTALL_MODE} "")
+
+# A change to a source is seen through a hard link but not by a copy.
+foreach(f linked.txt chmod.txt target.txt relinked.txt rechmod.txt)
+  file(APPEND ${dir}/src/${f} "changed\n")
+  file(READ ${dir}/dst/${f} content)
+  if(content MATCHES "changed")
+    message("${f} linked")
+  else()
+    message("${f} copied")
+  endif()
+endforeach()
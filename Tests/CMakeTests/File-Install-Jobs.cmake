@@ -0,0 +1,51 @@
+set(dir ${CMAKE_CURRENT_BINARY_DIR}/File-Install-Jobs)
+file(REMOVE_RECURSE ${dir})
+file(MAKE_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/CMakeFiles)
+
+# Enough files for several worker processes, including modes with bits
+# file(INSTALL) has no keyword for.
+set(files)
+foreach(i RANGE 1 64)
+  file(WRITE ${dir}/src/f${i}.txt "${i}\n")
+  list(APPEND files ${dir}/src/f${i}.txt)
+endforeach()
+execute_process(COMMAND chmod 1755 ${dir}/src/f1.txt)
+execute_process(COMMAND chmod 2755 ${dir}/src/f2.txt)
+execute_process(COMMAND chmod 600 ${dir}/src/f3.txt)
+
+# Install the files in process and by workers and list the manifest
+# and the mode of every file installed.
+foreach(jobs 1 4)
+  set(ENV{CMAKE_INSTALL_JOBS} ${jobs})
+  set(CMAKE_INSTALL_MANIFEST_FILES)
+  file(INSTALL ${files} DESTINATION ${dir}/jobs${jobs}
+    USE_SOURCE_PERMISSIONS)
+  set(manifest${jobs})
+  foreach(f ${CMAKE_INSTALL_MANIFEST_FILES})
+    string(REPLACE "${dir}/jobs${jobs}/" "" f "${f}")
+    list(APPEND manifest${jobs} "${f}")
+  endforeach()
+  list(SORT manifest${jobs})
+  execute_process(COMMAND ls -l WORKING_DIRECTORY ${dir}/jobs${jobs}
+    OUTPUT_VARIABLE ls)
+  string(REGEX MATCHALL "[-rwxsStT]+[^\n]* f[0-9]+\\.txt" lines "${ls}")
+  set(modes${jobs})
+  foreach(line ${lines})
+    string(REGEX REPLACE "^([-rwxsStT]+).* (f[0-9]+\\.txt)$" "\\2 \\1"
+      line "${line}")
+    list(APPEND modes${jobs} "${line}")
+  endforeach()
+  list(SORT modes${jobs})
+endforeach()
+set(ENV{CMAKE_INSTALL_JOBS} "")
+
+list(LENGTH manifest1 count)
+if(NOT count EQUAL 64)
+  message(FATAL_ERROR "Installed ${count} files instead of 64")
+endif()
+if(NOT "${manifest4}" STREQUAL "${manifest1}")
+  message(FATAL_ERROR "Manifests differ:\n${manifest1}\n${manifest4}")
+endif()
+if(NOT "${modes4}" STREQUAL "${modes1}")
+  message(FATAL_ERROR "Modes differ:\n${modes1}\n${modes4}")
+endif()
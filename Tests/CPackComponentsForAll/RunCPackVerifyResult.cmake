@@ -82,6 +82,12 @@ if(CPackGen MATCHES "DragNDrop")
     endif ()
 endif(CPackGen MATCHES "DragNDrop")
 
+# The IgnoreGroup config installs the components concurrently.
+if(CPackGen MATCHES "ZIP" AND ${CPackComponentWay} STREQUAL "IgnoreGroup")
+    set(config_verbose -V)
+    set(expected_output "Install 4 components with 4 processes")
+endif()
+
 # clean-up previously CPack generated files
 if(expected_file_mask)
   file(GLOB expected_file "${expected_file_mask}")
@@ -104,6 +110,10 @@ else (CPack_result)
   message(STATUS "CPack_output=${CPack_output}")
 endif(CPack_result)
 
+if(expected_output AND NOT "${CPack_output}" MATCHES "${expected_output}")
+  message(FATAL_ERROR "error: CPack output does not contain \"${expected_output}\": CPackComponentsForAll test fails. (CPack_output=${CPack_output}, CPack_error=${CPack_error})")
+endif()
+
 # Now verify if the number of expected file is OK
 # - using expected_file_mask and
 # - expected_count
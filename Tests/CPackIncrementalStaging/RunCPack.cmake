@@ -0,0 +1,88 @@
+if(NOT DEFINED CMake_SOURCE_DIR)
+  message(FATAL_ERROR "CMake_SOURCE_DIR not defined")
+endif()
+
+if(NOT DEFINED dir)
+  message(FATAL_ERROR "dir not defined")
+endif()
+
+if(NOT DEFINED gen)
+  message(FATAL_ERROR "gen not defined")
+endif()
+
+if(NOT DEFINED cpack)
+  message(FATAL_ERROR "cpack not defined")
+endif()
+
+# Run cpack several times with CPACK_INCREMENTAL_STAGING and check which
+# component packages are written again and what they contain.
+#
+execute_process(COMMAND ${CMAKE_COMMAND} -E remove_directory ${dir})
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${dir})
+
+function(configure)
+  execute_process(COMMAND ${CMAKE_COMMAND} -G ${gen} ${ARGN}
+    ${CMake_SOURCE_DIR}/Tests/CPackIncrementalStaging
+    WORKING_DIRECTORY ${dir}
+    RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+  if(result)
+    message(FATAL_ERROR "Configuring failed:\n${out}")
+  endif()
+endfunction()
+
+# Run cpack and return the components whose package was kept.
+function(run_cpack var)
+  # Let every file installed get a time different from the last run.
+  execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1.1)
+  execute_process(COMMAND ${cpack} -V
+    WORKING_DIRECTORY ${dir}
+    RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+  if(result)
+    message(FATAL_ERROR "Running cpack failed:\n${out}")
+  endif()
+  string(REGEX MATCHALL "reuse package: [^\n]*-[a-z]+\\.tar\\.gz"
+    reused "${out}")
+  string(REGEX REPLACE "reuse package: [^\n;]*-([a-z]+)\\.tar\\.gz" "\\1"
+    reused "${reused}")
+  set(${var} "${reused}" PARENT_SCOPE)
+endfunction()
+
+# Check the files in the package of a component.
+function(check_package component)
+  file(GLOB package ${dir}/Incremental-1.0-*-${component}.tar.gz)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E tar tzf ${package}
+    RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+  if(result)
+    message(FATAL_ERROR "Listing ${package} failed:\n${out}")
+  endif()
+  string(REGEX MATCHALL "[a-z]+\\.txt" files "${out}")
+  list(SORT files)
+  if(NOT "${files}" STREQUAL "${ARGN}")
+    message(FATAL_ERROR "The ${component} package contains \"${files}\" "
+      "instead of \"${ARGN}\"")
+  endif()
+endfunction()
+
+configure()
+run_cpack(reused)
+if(NOT "${reused}" STREQUAL "")
+  message(FATAL_ERROR "The first run reused packages: ${reused}")
+endif()
+check_package(edited stripped.txt)
+check_package(changing extra.txt other.txt)
+
+# Installing again changes nothing but the time of the edited file.
+run_cpack(reused)
+if(NOT "${reused}" STREQUAL "changing;edited")
+  message(FATAL_ERROR "Unchanged packages were not all reused: ${reused}")
+endif()
+
+# A file no longer installed is removed from its package.
+configure(-DINSTALL_EXTRA=OFF)
+run_cpack(reused)
+if(NOT "${reused}" STREQUAL "edited")
+  message(FATAL_ERROR "Only the edited package was expected to be reused, "
+    "not \"${reused}\"")
+endif()
+check_package(edited stripped.txt)
+check_package(changing other.txt)
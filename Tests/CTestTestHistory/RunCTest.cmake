@@ -0,0 +1,69 @@
+if(NOT DEFINED dir)
+  message(FATAL_ERROR "dir not defined")
+endif()
+
+if(NOT DEFINED ctest)
+  message(FATAL_ERROR "ctest not defined")
+endif()
+
+# Check that --fail-on-performance-regression fails a run in which a test
+# is much slower than in the runs recorded in its history.
+#
+execute_process(COMMAND ${CMAKE_COMMAND} -E remove_directory ${dir})
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${dir})
+set(history ${dir}/Testing/Temporary/CTestTestHistory.txt)
+
+# Run a test taking about the given number of seconds after seeding its
+# history with five earlier runs taking between 1 and 1.5 seconds.
+# The ctest arguments follow the number of seconds.
+function(run_timed seconds var out_var)
+  file(WRITE ${dir}/CTestTestfile.cmake "add_test(Timed \"${CMAKE_COMMAND}\"
+  -E sleep ${seconds})\n")
+  file(WRITE ${history} "Timed 1,0 1.5,0 1,0 1.5,0 1,0\n")
+  execute_process(COMMAND ${ctest} ${ARGN}
+    WORKING_DIRECTORY ${dir}
+    RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+  set(${var} "${result}" PARENT_SCOPE)
+  set(${out_var} "${out}" PARENT_SCOPE)
+endfunction()
+
+run_timed(1 result out --fail-on-performance-regression)
+if(result)
+  message(FATAL_ERROR "A run as fast as the earlier ones failed:\n${out}")
+endif()
+file(READ ${history} content)
+if(NOT "${content}" MATCHES "^Timed 1,0 1.5,0 1,0 1.5,0 1,0 [0-9.]+,[0-9]+\n$")
+  message(FATAL_ERROR "The run was not added to the history:\n${content}")
+endif()
+
+run_timed(4 result out --fail-on-performance-regression)
+if(NOT result)
+  message(FATAL_ERROR "A run much slower than the earlier ones passed:\n"
+    "${out}")
+endif()
+if(NOT "${out}" MATCHES "slower than in earlier runs")
+  message(FATAL_ERROR "The slower test was not reported:\n${out}")
+endif()
+
+# The same through the ctest_test command of a dashboard script.
+foreach(fail on off)
+  file(WRITE ${dir}/test-${fail}.cmake "
+set(CTEST_SITE test-site)
+set(CTEST_BUILD_NAME test-build)
+set(CTEST_SOURCE_DIRECTORY \"${dir}\")
+set(CTEST_BINARY_DIRECTORY \"${dir}\")
+ctest_start(Experimental)
+ctest_test(FAIL_ON_PERFORMANCE_REGRESSION ${fail} RETURN_VALUE result)
+message(\"Result: \${result}\")
+")
+endforeach()
+run_timed(4 result out -S ${dir}/test-off.cmake)
+if(NOT "${out}" MATCHES "Result: 0\n")
+  message(FATAL_ERROR "ctest_test failed without "
+    "FAIL_ON_PERFORMANCE_REGRESSION:\n${out}")
+endif()
+run_timed(4 result out -S ${dir}/test-on.cmake)
+if(NOT "${out}" MATCHES "Result: -?[1-9][0-9]*\n")
+  message(FATAL_ERROR "ctest_test passed with "
+    "FAIL_ON_PERFORMANCE_REGRESSION:\n${out}")
+endif()
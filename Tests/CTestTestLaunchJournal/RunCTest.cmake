@@ -0,0 +1,58 @@
+if(NOT DEFINED dir)
+  message(FATAL_ERROR "dir not defined")
+endif()
+
+if(NOT DEFINED ctest)
+  message(FATAL_ERROR "ctest not defined")
+endif()
+
+# Check that the build report keeps the records of the launcher journal
+# that follow a record cut short by an interrupted launcher.
+#
+execute_process(COMMAND ${CMAKE_COMMAND} -E remove_directory ${dir})
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${dir})
+
+# The "build" writes the journal as launchers would.  Each record is
+# "CTLJ", E or W, a 32-character command hash, an 8 hex digit length,
+# and then the fragment.
+set(hash1 0123456789abcdef0123456789abcdef)
+set(hash2 fedcba9876543210fedcba9876543210)
+set(fragment "<Failure type=\"Error\"><Text>kept record</Text></Failure>\n")
+string(LENGTH "${fragment}" length)
+if(NOT length EQUAL 57)
+  message(FATAL_ERROR "The fragment is ${length} bytes, not 0x39")
+endif()
+file(WRITE ${dir}/build.cmake "
+set(journal \$ENV{CTEST_LAUNCH_LOGS}/fragments.journal)
+file(WRITE \${journal}
+  \"CTLJE${hash1}00000100<Failure type=\\\"Error\\\"><Text>lost rec\")
+file(APPEND \${journal} \"CTLJE${hash2}00000039\")
+file(APPEND \${journal}
+  \"<Failure type=\\\"Error\\\"><Text>kept record</Text></Failure>\\n\")
+")
+file(WRITE ${dir}/test.cmake "
+set(CTEST_SITE test-site)
+set(CTEST_BUILD_NAME test-build)
+set(CTEST_SOURCE_DIRECTORY \"${dir}\")
+set(CTEST_BINARY_DIRECTORY \"${dir}\")
+set(CTEST_BUILD_COMMAND \"\\\"${CMAKE_COMMAND}\\\" -P build.cmake\")
+set(CTEST_USE_LAUNCHERS 1)
+ctest_start(Experimental)
+ctest_build(NUMBER_ERRORS errors)
+message(\"Errors: \${errors}\")
+")
+# The reported error fails the run, so check only its output.
+execute_process(COMMAND ${ctest} -S ${dir}/test.cmake
+  WORKING_DIRECTORY ${dir}
+  OUTPUT_VARIABLE out ERROR_VARIABLE out)
+if(NOT "${out}" MATCHES "Errors: 1\n")
+  message(FATAL_ERROR "The build did not report one error:\n${out}")
+endif()
+
+file(READ ${dir}/Testing/TAG tag)
+string(REGEX REPLACE "\n.*" "" tag "${tag}")
+file(READ ${dir}/Testing/${tag}/Build.xml xml)
+if(NOT "${xml}" MATCHES "kept record" OR "${xml}" MATCHES "lost rec|CTLJ")
+  message(FATAL_ERROR "Build.xml does not hold just the complete record:\n"
+    "${xml}")
+endif()
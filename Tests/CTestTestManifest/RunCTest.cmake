@@ -0,0 +1,102 @@
+if(NOT DEFINED dir)
+  message(FATAL_ERROR "dir not defined")
+endif()
+
+if(NOT DEFINED ctest)
+  message(FATAL_ERROR "ctest not defined")
+endif()
+
+# Check that ctest reuses the list of tests it read before only while
+# the test files are known to be unchanged.
+#
+execute_process(COMMAND ${CMAKE_COMMAND} -E remove_directory ${dir})
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${dir})
+
+# Write a test file declaring one test with the given name.  All names
+# have the same length so the file size never changes.
+function(write_testfile name)
+  file(WRITE ${dir}/CTestTestfile.cmake
+    "add_test(${name} \"${CMAKE_COMMAND}\" -E echo ${name})\n")
+endfunction()
+
+# Return the names of the tests ctest finds and whether it read them
+# from the manifest.
+function(list_tests var cached)
+  execute_process(COMMAND ${ctest} -N -V
+    WORKING_DIRECTORY ${dir}
+    RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+  if(result)
+    message(FATAL_ERROR "Listing the tests failed:\n${out}")
+  endif()
+  string(REGEX MATCHALL "Test #[0-9]+: [A-Za-z]+" tests "${out}")
+  string(REGEX REPLACE "Test #[0-9]+: " "" tests "${tests}")
+  set(${var} "${tests}" PARENT_SCOPE)
+  if("${out}" MATCHES "Read the list of tests from")
+    set(${cached} 1 PARENT_SCOPE)
+  else()
+    set(${cached} 0 PARENT_SCOPE)
+  endif()
+endfunction()
+
+# Rewrite the test file immediately after it is read, most likely within
+# the same second and always with the same size.
+write_testfile(TestAAA)
+list_tests(tests cached)
+if(NOT "${tests}" STREQUAL "TestAAA")
+  message(FATAL_ERROR "Found tests \"${tests}\" instead of TestAAA")
+endif()
+write_testfile(TestBBB)
+list_tests(tests cached)
+if(NOT "${tests}" STREQUAL "TestBBB")
+  message(FATAL_ERROR "Found tests \"${tests}\" instead of TestBBB "
+    "after rewriting CTestTestfile.cmake")
+endif()
+
+# Once the test file is older than the manifest the list is reused.
+execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1.1)
+list_tests(tests cached)
+list_tests(tests cached)
+if(NOT "${tests}" STREQUAL "TestBBB" OR NOT cached)
+  message(FATAL_ERROR "The list of tests was not reused")
+endif()
+write_testfile(TestCCC)
+list_tests(tests cached)
+if(NOT "${tests}" STREQUAL "TestCCC" OR cached)
+  message(FATAL_ERROR "Found tests \"${tests}\" instead of TestCCC "
+    "after rewriting CTestTestfile.cmake")
+endif()
+
+# Tests declared in subdirectories are reused as well.
+file(WRITE ${dir}/CTestTestfile.cmake "subdirs(sub)\n")
+file(WRITE ${dir}/sub/CTestTestfile.cmake
+  "add_test(TestSUB \"${CMAKE_COMMAND}\" -E echo TestSUB)\n")
+execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1.1)
+list_tests(tests cached)
+list_tests(tests cached)
+if(NOT "${tests}" STREQUAL "TestSUB" OR NOT cached)
+  message(FATAL_ERROR "The list of tests from a subdirectory was not "
+    "reused, found \"${tests}\"")
+endif()
+
+# The manifest cannot replay other commands, so test files using them
+# are always read.  Here the tests depend on a file that is not a test
+# file.
+file(WRITE ${dir}/CTestTestfile.cmake "include(\"${dir}/tests.cmake\")\n")
+file(WRITE ${dir}/tests.cmake "if(EXISTS \"${dir}/flag\")
+  add_test(TestON \"${CMAKE_COMMAND}\" -E echo TestON)
+else()
+  add_test(TestOFF \"${CMAKE_COMMAND}\" -E echo TestOFF)
+endif()
+")
+execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1.1)
+list_tests(tests cached)
+list_tests(tests cached)
+if(NOT "${tests}" STREQUAL "TestOFF" OR cached)
+  message(FATAL_ERROR "Found tests \"${tests}\" instead of TestOFF "
+    "or reused the list of tests from an included file")
+endif()
+file(WRITE ${dir}/flag "")
+list_tests(tests cached)
+if(NOT "${tests}" STREQUAL "TestON")
+  message(FATAL_ERROR "Found tests \"${tests}\" instead of TestON")
+endif()
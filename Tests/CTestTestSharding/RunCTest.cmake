@@ -0,0 +1,150 @@
+if(NOT DEFINED CMake_SOURCE_DIR)
+  message(FATAL_ERROR "CMake_SOURCE_DIR not defined")
+endif()
+
+if(NOT DEFINED dir)
+  message(FATAL_ERROR "dir not defined")
+endif()
+
+if(NOT DEFINED gen)
+  message(FATAL_ERROR "gen not defined")
+endif()
+
+if(NOT DEFINED ctest)
+  message(FATAL_ERROR "ctest not defined")
+endif()
+
+# Pretend that two machines each run one shard of the tests in their own
+# build tree and then merge the results into a third tree.
+#
+execute_process(COMMAND ${CMAKE_COMMAND} -E remove_directory ${dir})
+
+# Return the names of the tests recorded in the Test.xml of a tree.
+function(get_tests tree var)
+  file(READ ${tree}/Testing/TAG tag)
+  string(REGEX REPLACE "\n.*" "" tag "${tag}")
+  file(READ ${tree}/Testing/${tag}/Test.xml xml)
+  string(REGEX MATCHALL "<Name>[^<]*</Name>" names "${xml}")
+  string(REGEX REPLACE "</?Name>" "" names "${names}")
+  set(${var} ${names} PARENT_SCOPE)
+endfunction()
+
+# Run both shards, each in its own tree, with the given extra arguments.
+function(run_shards)
+  foreach(shard 1 2)
+    set(tree ${dir}/Shard${shard})
+    execute_process(COMMAND ${ctest} -T Test --shard ${shard}/2 ${ARGN}
+      WORKING_DIRECTORY ${tree}
+      RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+    if(result)
+      message(FATAL_ERROR "Testing shard ${shard} failed:\n${out}")
+    endif()
+    get_tests(${tree} tests${shard})
+    message(STATUS "Shard ${shard}: ${tests${shard}}")
+    set(tests${shard} ${tests${shard}} PARENT_SCOPE)
+  endforeach()
+endfunction()
+
+# Check that every test ran exactly once.
+function(check_shards)
+  foreach(i RANGE 1 12)
+    list(FIND tests1 Test${i} in1)
+    list(FIND tests2 Test${i} in2)
+    if(in1 EQUAL -1 AND in2 EQUAL -1)
+      message(FATAL_ERROR "Test${i} did not run")
+    endif()
+    if(NOT in1 EQUAL -1 AND NOT in2 EQUAL -1)
+      message(FATAL_ERROR "Test${i} ran in both shards")
+    endif()
+  endforeach()
+endfunction()
+
+foreach(shard 1 2)
+  set(tree ${dir}/Shard${shard})
+  execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${tree})
+  execute_process(COMMAND ${CMAKE_COMMAND} -G ${gen}
+    ${CMake_SOURCE_DIR}/Tests/CTestTestSharding
+    WORKING_DIRECTORY ${tree}
+    RESULT_VARIABLE result OUTPUT_QUIET)
+  if(result)
+    message(FATAL_ERROR "Configuring shard ${shard} failed: ${result}")
+  endif()
+endforeach()
+run_shards()
+
+# Every test runs exactly once and related tests share a shard.
+list(LENGTH tests1 n1)
+list(LENGTH tests2 n2)
+if(NOT n1 EQUAL 6 OR NOT n2 EQUAL 6)
+  message(FATAL_ERROR "Shards are not balanced: ${n1} and ${n2} tests")
+endif()
+check_shards()
+foreach(pair "Test1;Test2" "Test5;Test9")
+  list(GET pair 0 a)
+  list(GET pair 1 b)
+  list(FIND tests1 ${a} ina)
+  list(FIND tests1 ${b} inb)
+  if((ina EQUAL -1 AND NOT inb EQUAL -1) OR
+     (inb EQUAL -1 AND NOT ina EQUAL -1))
+    message(FATAL_ERROR "${a} and ${b} ran in different shards")
+  endif()
+endforeach()
+
+execute_process(COMMAND ${ctest} --shard 3/2 -N
+  WORKING_DIRECTORY ${dir}/Shard1
+  RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+if(NOT result)
+  message(FATAL_ERROR "An invalid shard was accepted")
+endif()
+
+# Merge both shards into one report.
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${dir}/Merged)
+execute_process(COMMAND ${ctest}
+  --merge-results ${dir}/Shard1 --merge-results ${dir}/Shard2
+  WORKING_DIRECTORY ${dir}/Merged
+  RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+if(result)
+  message(FATAL_ERROR "Merging the shards failed:\n${out}")
+endif()
+get_tests(${dir}/Merged merged)
+list(SORT merged)
+set(expect ${tests1} ${tests2})
+list(SORT expect)
+if(NOT "${merged}" STREQUAL "${expect}")
+  message(FATAL_ERROR "Merged results contain:\n  ${merged}\n"
+    "but expected:\n  ${expect}")
+endif()
+
+# The cost data left by the first round differs between the trees.  Make
+# it disagree more so that splitting by it would give other partitions.
+foreach(shard 1 2)
+  set(costs "")
+  foreach(i RANGE 1 12)
+    if((shard EQUAL 1 AND i LESS 7) OR (shard EQUAL 2 AND i GREATER 6))
+      set(costs "${costs}Test${i} 1 100\n")
+    else()
+      set(costs "${costs}Test${i} 1 1\n")
+    endif()
+  endforeach()
+  file(WRITE ${dir}/Shard${shard}/Testing/Temporary/CTestCostData.txt
+    "${costs}---\n")
+endforeach()
+run_shards()
+check_shards()
+
+# A cost data file shared by both shards balances the split.
+set(costs "")
+foreach(i RANGE 1 12)
+  if(i EQUAL 3)
+    set(costs "${costs}Test${i} 1 1000\n")
+  else()
+    set(costs "${costs}Test${i} 1 1\n")
+  endif()
+endforeach()
+file(WRITE ${dir}/SharedCostData.txt "${costs}---\n")
+run_shards(--shard-cost-data ${dir}/SharedCostData.txt)
+check_shards()
+if(NOT "${tests1}" STREQUAL "Test3" AND NOT "${tests2}" STREQUAL "Test3")
+  message(FATAL_ERROR "The shared cost data was not used to balance the "
+    "shards:\n  ${tests1}\n  ${tests2}")
+endif()
@@ -0,0 +1,103 @@
+if(NOT DEFINED CMake_SOURCE_DIR)
+  message(FATAL_ERROR "CMake_SOURCE_DIR not defined")
+endif()
+
+if(NOT DEFINED dir)
+  message(FATAL_ERROR "dir not defined")
+endif()
+
+if(NOT DEFINED gen)
+  message(FATAL_ERROR "gen not defined")
+endif()
+
+if(NOT DEFINED ctest)
+  message(FATAL_ERROR "ctest not defined")
+endif()
+
+# Submit to a local HTTP server with CTEST_COMPRESS_SUBMISSION and check
+# that the files are sent gzip-encoded and that a submission which
+# failed for one file resumes with just that file.
+#
+execute_process(COMMAND ${CMAKE_COMMAND} -E remove_directory ${dir})
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${dir}/server)
+execute_process(COMMAND ${CMAKE_COMMAND} -G ${gen}
+  ${CMake_SOURCE_DIR}/Tests/CTestTestSubmitHTTP
+  WORKING_DIRECTORY ${dir}/server
+  RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+if(NOT result)
+  execute_process(COMMAND ${CMAKE_COMMAND} --build ${dir}/server
+    RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+endif()
+if(result)
+  message(FATAL_ERROR "Building the server failed:\n${out}")
+endif()
+find_program(server PutServer PATHS ${dir}/server
+  PATH_SUFFIXES Debug Release NO_DEFAULT_PATH)
+
+set(common "
+set(CTEST_SITE test-site)
+set(CTEST_BUILD_NAME test-build)
+set(CTEST_SOURCE_DIRECTORY \"${dir}\")
+set(CTEST_BINARY_DIRECTORY \"${dir}\")
+set(CTEST_DROP_METHOD http)
+set(CTEST_DROP_SITE \"127.0.0.1:\$ENV{CTEST_TEST_SUBMIT_PORT}\")
+set(CTEST_DROP_LOCATION \"/submit.php?project=Test\")
+set(CTEST_DROP_SITE_CDASH TRUE)
+set(CTEST_COMPRESS_SUBMISSION ON)
+")
+file(WRITE ${dir}/first.cmake "${common}
+set(CTEST_CONFIGURE_COMMAND \"\\\"${CMAKE_COMMAND}\\\" -E echo configured\")
+ctest_start(Experimental)
+ctest_configure()
+ctest_test()
+ctest_submit(RETRY_COUNT 0)
+")
+file(WRITE ${dir}/resume.cmake "${common}
+ctest_start(Experimental APPEND)
+ctest_submit(RETRY_COUNT 0)
+")
+
+# Run a dashboard script while the server fails requests for the files
+# matching fail, and return the files the server received.  The journal
+# of a submission is kept per URL, so every submission after the first
+# goes to the same port.
+set(port 0)
+function(submit script fail var)
+  file(REMOVE ${dir}/requests.log)
+  execute_process(COMMAND ${server} ${dir}/requests.log "${fail}" ${port}
+    ${ctest} -S ${dir}/${script}.cmake -V
+    WORKING_DIRECTORY ${dir}
+    OUTPUT_VARIABLE out ERROR_VARIABLE out)
+  if(NOT "${out}" MATCHES "PutServer port ([0-9]+)")
+    message(FATAL_ERROR "The server did not start:\n${out}")
+  endif()
+  set(port ${CMAKE_MATCH_1} PARENT_SCOPE)
+  file(STRINGS ${dir}/requests.log requests)
+  set(${var} "${requests}" PARENT_SCOPE)
+  message(STATUS "${script}: ${requests}")
+endfunction()
+
+submit(first Test.xml requests)
+list(LENGTH requests n)
+if(NOT n EQUAL 2)
+  message(FATAL_ERROR "Expected two uploads, got: ${requests}")
+endif()
+foreach(request ${requests})
+  if(NOT "${request}" MATCHES "^[^ ]*(Configure|Test)\\.xml gzip gzip$")
+    message(FATAL_ERROR "Upload was not gzip encoded: ${request}")
+  endif()
+endforeach()
+
+submit(resume "" requests)
+if(NOT "${requests}" MATCHES "^[^ ;]*Test\\.xml gzip gzip$")
+  message(FATAL_ERROR "The resumed submission did not upload only "
+    "Test.xml: ${requests}")
+endif()
+
+# A complete submission leaves nothing to resume.
+submit(resume "" requests)
+list(LENGTH requests n)
+if(NOT n EQUAL 2)
+  message(FATAL_ERROR "Expected two uploads after a complete submission, "
+    "got: ${requests}")
+endif()
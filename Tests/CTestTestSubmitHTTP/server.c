@@ -0,0 +1,235 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* A minimal HTTP server accepting PUT requests as sent by ctest_submit.
+
+     PutServer <log> <fail> <port> <command> [args...]
+
+   Listens on the given port, or on any free port if it is 0, and prints
+   the port.  Runs the command with CTEST_TEST_SUBMIT_PORT set to the
+   port and serves requests until the command exits.  Each
+   request is logged as "<FileName> <Content-Encoding> <magic>", where
+   magic is "gzip" if the body starts with the gzip header.  Requests
+   for a FileName containing <fail> are answered with an error.  */
+
+static int read_byte(int fd, char* c)
+{
+  return read(fd, c, 1) == 1;
+}
+
+static int read_line(int fd, char* line, size_t size)
+{
+  size_t n = 0;
+  char c;
+  while(read_byte(fd, &c))
+    {
+    if(c == '\n')
+      {
+      if(n > 0 && line[n-1] == '\r')
+        {
+        --n;
+        }
+      line[n] = 0;
+      return 1;
+      }
+    if(n + 1 < size)
+      {
+      line[n++] = c;
+      }
+    }
+  return 0;
+}
+
+/* Read n bytes, keeping the first two in magic.  */
+static int read_body(int fd, unsigned long n, unsigned char* magic,
+                     unsigned long* total)
+{
+  char c;
+  for(; n > 0; --n)
+    {
+    if(!read_byte(fd, &c))
+      {
+      return 0;
+      }
+    if(*total < 2)
+      {
+      magic[*total] = (unsigned char)c;
+      }
+    ++*total;
+    }
+  return 1;
+}
+
+static void write_string(int fd, const char* s)
+{
+  size_t n = strlen(s);
+  while(n > 0)
+    {
+    ssize_t w = write(fd, s, n);
+    if(w <= 0)
+      {
+      return;
+      }
+    s += w;
+    n -= (size_t)w;
+    }
+}
+
+/* Serve one request.  Returns 0 when the connection is done.  */
+static int serve(int fd, FILE* log, const char* fail)
+{
+  char line[4096];
+  char name[1024] = "";
+  char encoding[64] = "identity";
+  int chunked = 0;
+  unsigned long length = 0;
+  unsigned char magic[2] = {0, 0};
+  unsigned long total = 0;
+  const char* p;
+
+  if(!read_line(fd, line, sizeof(line)) || !line[0])
+    {
+    return 0;
+    }
+  if((p = strstr(line, "FileName=")) != 0)
+    {
+    size_t n = strcspn(p + 9, "& ");
+    n = n < sizeof(name)-1? n : sizeof(name)-1;
+    memcpy(name, p + 9, n);
+    name[n] = 0;
+    }
+  while(read_line(fd, line, sizeof(line)) && line[0])
+    {
+    if(strncmp(line, "Content-Length:", 15) == 0)
+      {
+      length = strtoul(line + 15, 0, 10);
+      }
+    else if(strncmp(line, "Content-Encoding:", 17) == 0)
+      {
+      sscanf(line + 17, " %63s", encoding);
+      }
+    else if(strncmp(line, "Transfer-Encoding:", 18) == 0 &&
+            strstr(line, "chunked"))
+      {
+      chunked = 1;
+      }
+    else if(strncmp(line, "Expect:", 7) == 0)
+      {
+      write_string(fd, "HTTP/1.1 100 Continue\r\n\r\n");
+      }
+    }
+
+  if(chunked)
+    {
+    unsigned long n;
+    do
+      {
+      if(!read_line(fd, line, sizeof(line)))
+        {
+        return 0;
+        }
+      n = strtoul(line, 0, 16);
+      if(!read_body(fd, n, magic, &total) ||
+         !read_line(fd, line, sizeof(line)))
+        {
+        return 0;
+        }
+      } while(n > 0);
+    }
+  else if(!read_body(fd, length, magic, &total))
+    {
+    return 0;
+    }
+
+  fprintf(log, "%s %s %s\n", name, encoding,
+          (total >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)?
+          "gzip" : "plain");
+  fflush(log);
+  if(fail[0] && strstr(name, fail))
+    {
+    write_string(fd, "HTTP/1.1 500 Internal Server Error\r\n"
+                 "Content-Length: 0\r\nConnection: close\r\n\r\n");
+    return 0;
+    }
+  write_string(fd, "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+  return 1;
+}
+
+int main(int argc, char** argv)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  char port[32];
+  FILE* log;
+  pid_t child;
+  int status = 1;
+  int sock;
+  int on = 1;
+
+  if(argc < 5)
+    {
+    fprintf(stderr, "usage: PutServer <log> <fail> <port> <command>...\n");
+    return 1;
+    }
+  log = fopen(argv[1], "a");
+  sock = socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons((unsigned short)atoi(argv[3]));
+  if(!log || sock < 0 ||
+     setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+     bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+     listen(sock, 5) < 0 ||
+     getsockname(sock, (struct sockaddr*)&addr, &len) < 0)
+    {
+    perror("PutServer");
+    return 1;
+    }
+  sprintf(port, "%d", (int)ntohs(addr.sin_port));
+  setenv("CTEST_TEST_SUBMIT_PORT", port, 1);
+  printf("PutServer port %s\n", port);
+  fflush(stdout);
+
+  child = fork();
+  if(child == 0)
+    {
+    close(sock);
+    execvp(argv[4], argv + 4);
+    perror("PutServer");
+    _exit(127);
+    }
+
+  for(;;)
+    {
+    fd_set fds;
+    struct timeval tv;
+    if(waitpid(child, &status, WNOHANG) == child)
+      {
+      break;
+      }
+    FD_ZERO(&fds);
+    FD_SET(sock, &fds);
+    tv.tv_sec = 0;
+    tv.tv_usec = 100000;
+    if(select(sock + 1, &fds, 0, 0, &tv) > 0)
+      {
+      int fd = accept(sock, 0, 0);
+      if(fd >= 0)
+        {
+        while(serve(fd, log, argv[2])) {}
+        close(fd);
+        }
+      }
+    }
+  fclose(log);
+  return WIFEXITED(status)? WEXITSTATUS(status) : 1;
+}
@@ -0,0 +1,72 @@
+if(NOT DEFINED dir)
+  message(FATAL_ERROR "dir not defined")
+endif()
+
+if(NOT DEFINED gen)
+  message(FATAL_ERROR "gen not defined")
+endif()
+
+# Check that touching a CMakeLists.txt file without changing its content
+# does not rerun CMake when CMAKE_SKIP_UNCHANGED_REGENERATION is enabled,
+# while a real change still does.
+#
+set(src ${dir}/Source)
+set(bin ${dir}/Build)
+execute_process(COMMAND ${CMAKE_COMMAND} -E remove_directory ${dir})
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${src})
+execute_process(COMMAND ${CMAKE_COMMAND} -E make_directory ${bin})
+
+set(project_content "cmake_minimum_required(VERSION 2.8)
+project(SkipUnchangedRegeneration NONE)
+set(CMAKE_SKIP_UNCHANGED_REGENERATION ON)
+file(APPEND \${CMAKE_BINARY_DIR}/configure-count.txt x)
+")
+file(WRITE ${src}/CMakeLists.txt "${project_content}")
+
+# Wait long enough for new file times to differ from the old ones.
+macro(wait_for_new_time)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1.1)
+endmacro()
+
+# Build the project and return how many times it has been configured.
+function(build_and_count var)
+  execute_process(COMMAND ${CMAKE_COMMAND} --build ${bin}
+    RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+  if(result)
+    message(FATAL_ERROR "Building failed:\n${out}")
+  endif()
+  file(READ ${bin}/configure-count.txt count)
+  string(LENGTH "${count}" count)
+  set(${var} ${count} PARENT_SCOPE)
+endfunction()
+
+execute_process(COMMAND ${CMAKE_COMMAND} -G ${gen} ${src}
+  WORKING_DIRECTORY ${bin}
+  RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE out)
+if(result)
+  message(FATAL_ERROR "Configuring failed:\n${out}")
+endif()
+build_and_count(count)
+if(NOT count EQUAL 1)
+  message(FATAL_ERROR "Initial build configured ${count} times, not 1")
+endif()
+
+wait_for_new_time()
+execute_process(COMMAND ${CMAKE_COMMAND} -E touch ${src}/CMakeLists.txt)
+build_and_count(count)
+if(NOT count EQUAL 1)
+  message(FATAL_ERROR "Touching an unchanged CMakeLists.txt reran CMake")
+endif()
+
+# The outputs were touched, so the next build must not hash again.
+build_and_count(count)
+if(NOT count EQUAL 1)
+  message(FATAL_ERROR "A build with no changes reran CMake")
+endif()
+
+wait_for_new_time()
+file(WRITE ${src}/CMakeLists.txt "${project_content}# changed\n")
+build_and_count(count)
+if(NOT count EQUAL 2)
+  message(FATAL_ERROR "Changing CMakeLists.txt did not rerun CMake")
+endif()